@@ -0,0 +1,70 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace aw::bench
+{
+	using namespace aw::core;
+
+	/**
+	 * Runs 'fn(thread_index)' on 'num_threads' threads at the same time and prints the time per operation.
+	 * 'num_ops' is the number of operations a single call of 'fn' performs.
+	 */
+	template <typename Fn>
+	f64 run(const std::string_view name, const u32 num_threads, const u64 num_ops, Fn&& fn)
+	{
+		std::atomic<u32>		 num_ready{};
+		std::atomic<bool>		 start{};
+		std::vector<std::thread> threads;
+		threads.reserve(num_threads);
+
+		for (u32 thread_index = 0; thread_index < num_threads; ++thread_index)
+		{
+			threads.emplace_back([&, thread_index] {
+				++num_ready;
+				while (!start.load(std::memory_order::acquire))
+				{
+					std::this_thread::yield();
+				}
+				fn(thread_index);
+			});
+		}
+
+		while (num_ready.load() != num_threads)
+		{
+			std::this_thread::yield();
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		start.store(true, std::memory_order::release);
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		const f64 total_ns = static_cast<f64>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+		const f64 ns_per_op = total_ns / static_cast<f64>(num_ops * num_threads);
+		std::printf("%-48.*s threads: %2u  %10.2f ns/op  %10.2f Mops/s\n", static_cast<int>(name.size()), name.data(), num_threads, ns_per_op, 1000.0 / ns_per_op);
+		return ns_per_op;
+	}
+
+	/** Keeps the compiler from optimizing the value away. */
+	template <typename T>
+	void do_not_optimize(T const& value)
+	{
+#if defined(_MSC_VER)
+		const volatile auto sink = &value;
+		(void)sink;
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+} // namespace aw::bench
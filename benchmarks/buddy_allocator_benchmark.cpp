@@ -0,0 +1,54 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr u64 NUM_CYCLES = 2'000;
+
+	// Sizes of decode buffers, from just under a page to 16 MB
+	constexpr std::array<usize, 6> BUFFER_SIZES = { 1'500'000, 3'900'000, 5'000'000, 8'000'000, 12'000'000, 16'000'000 };
+
+	// Allocates a buffer, writes its first and last OS page like a decoder filling it would start to, and frees it again.
+	template <typename Allocate, typename Free>
+	void run_buffer_churn(const std::string_view name, Allocate allocate, Free free)
+	{
+		aw::bench::run(name, 1, NUM_CYCLES, [&](u32) {
+			for (u64 cycle = 0; cycle < NUM_CYCLES; ++cycle)
+			{
+				const usize size = BUFFER_SIZES[cycle % BUFFER_SIZES.size()];
+				auto*		buffer = static_cast<u8*>(allocate(size));
+				std::memset(buffer, 0, 4096);
+				std::memset(buffer + size - 4096, 0, 4096);
+				aw::bench::do_not_optimize(buffer);
+				free(buffer);
+			}
+		});
+	}
+} // namespace
+
+int main()
+{
+	PagedMemoryPool& pool = PagedMemoryPool::get();
+
+	run_buffer_churn("decode buffers, buddy blocks", [&pool](const usize size) { return pool.allocate_memory(size); }, [](void* buffer) { PagedMemoryPool::free_memory(buffer); });
+
+	// Trimming after every free hands the memory back like the chunks of their own did
+	run_buffer_churn(
+		"decode buffers, returned to the OS",
+		[&pool](const usize size) { return pool.allocate_memory(size); },
+		[&pool](void* buffer) {
+			PagedMemoryPool::free_memory(buffer);
+			pool.trim();
+		});
+
+	run_buffer_churn("decode buffers, malloc", [](const usize size) { return std::malloc(size); }, [](void* buffer) { std::free(buffer); });
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include "benchmark.h"
+
+#include "aw/core/primitive/container_aliases.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr u32 NUM_KEYS = 1'000'000;
+	constexpr u32 NUM_STRING_KEYS = 200'000;
+	constexpr u32 NUM_ROUNDS = 5;
+
+	// Spread over the whole range, with the misses interleaved between the hits
+	std::vector<u64> make_keys(const u32 count, const u64 offset)
+	{
+		std::vector<u64> keys(count);
+		u64				 state = 0x2545f4914f6cdd1d + offset;
+		for (u64& key : keys)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			key = (state << 1) | offset;
+		}
+
+		return keys;
+	}
+
+	std::vector<std::string> make_string_keys(const u32 count, const char* prefix)
+	{
+		std::vector<std::string> keys(count);
+		for (u32 index = 0; index < count; ++index)
+		{
+			keys[index] = std::string(prefix) + std::to_string(index * 2654435761u) + "/file.bin";
+		}
+
+		return keys;
+	}
+
+	// Every round fills an empty map and erases all keys again, so each variant pays for its growth
+	template <typename Map, typename Key>
+	void run_map(const std::string_view name, const std::vector<Key>& keys, const std::vector<Key>& missing_keys)
+	{
+		const u64 num_ops = NUM_ROUNDS * keys.size();
+
+		Map map;
+		aw::bench::run(std::string(name) + ", insert", 1, num_ops, [&](u32) {
+			for (u32 round = 0; round < NUM_ROUNDS; ++round)
+			{
+				map = Map();
+				for (const Key& key : keys)
+				{
+					map.try_emplace(key, 1);
+				}
+			}
+		});
+
+		aw::bench::run(std::string(name) + ", hit", 1, num_ops, [&](u32) {
+			u64 sum = 0;
+			for (u32 round = 0; round < NUM_ROUNDS; ++round)
+			{
+				for (const Key& key : keys)
+				{
+					sum += map.find(key)->second;
+				}
+			}
+			aw::bench::do_not_optimize(sum);
+		});
+
+		aw::bench::run(std::string(name) + ", miss", 1, num_ops, [&](u32) {
+			u64 num_found = 0;
+			for (u32 round = 0; round < NUM_ROUNDS; ++round)
+			{
+				for (const Key& key : missing_keys)
+				{
+					num_found += map.contains(key);
+				}
+			}
+			aw::bench::do_not_optimize(num_found);
+		});
+
+		aw::bench::run(std::string(name) + ", erase", 1, keys.size(), [&](u32) {
+			for (const Key& key : keys)
+			{
+				map.erase(key);
+			}
+			aw::bench::do_not_optimize(map.size());
+		});
+	}
+} // namespace
+
+int main()
+{
+	const std::vector<u64> keys = make_keys(NUM_KEYS, 0);
+	const std::vector<u64> missing_keys = make_keys(NUM_KEYS, 1);
+	run_map<std::unordered_map<u64, u64>>("u64, std::unordered_map", keys, missing_keys);
+	run_map<HashMap<u64, u64>>("u64, FlatHashMap", keys, missing_keys);
+
+	// Paths as in the file systems, looked up by their own strings
+	const std::vector<std::string> string_keys = make_string_keys(NUM_STRING_KEYS, "assets://");
+	const std::vector<std::string> missing_string_keys = make_string_keys(NUM_STRING_KEYS, "shaders://");
+	run_map<std::unordered_map<std::string, u64>>("string, std::unordered_map", string_keys, missing_string_keys);
+	run_map<StringMap<u64>>("string, FlatHashMap", string_keys, missing_string_keys);
+
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/heap_profiler.h"
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <array>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr u64 NUM_OPS = 2'000'000;
+	constexpr u32 NUM_LIVE = 256;
+
+	// Keeps a window of live allocations of mixed sizes and replaces one of them per operation
+	void run_churn(const std::string_view name, const u64 sample_interval)
+	{
+		HeapProfiler::set_sample_interval(sample_interval);
+
+		aw::bench::run(name, 1, NUM_OPS, [](u32) {
+			PagedMemoryPool&			  pool = PagedMemoryPool::get();
+			std::array<void*, NUM_LIVE> live{};
+			for (u64 op = 0; op < NUM_OPS; ++op)
+			{
+				void*& slot = live[op % NUM_LIVE];
+				PagedMemoryPool::free_memory(slot);
+				slot = pool.allocate_memory(16 + (op * 37) % 2048);
+				aw::bench::do_not_optimize(slot);
+			}
+
+			for (void* memory : live)
+			{
+				PagedMemoryPool::free_memory(memory);
+			}
+		});
+	}
+} // namespace
+
+int main()
+{
+	run_churn("alloc+free churn, profiler disabled", 0);
+	run_churn("alloc+free churn, 1 sample per 2 MB", HeapProfiler::DEFAULT_SAMPLE_INTERVAL);
+	run_churn("alloc+free churn, 1 sample per 64 KB", 64 * 1024);
+
+	HeapProfiler::set_sample_interval(0);
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/linear_arena.h"
+#include "aw/core/primitive/container_aliases.h"
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr u64 NUM_REQUESTS = 2'000;
+	constexpr u32 NUM_VECTORS = 300;
+	constexpr u32 NUM_ELEMENTS = 24;
+
+	// A request builds a few hundred small vectors as scratch data and drops all of them at the end
+	template <typename Allocator>
+	void handle_request(const Allocator& allocator)
+	{
+		using VectorAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Vector<u32, Allocator>>;
+
+		Vector<Vector<u32, Allocator>, VectorAllocator> vectors{ VectorAllocator(allocator) };
+		vectors.reserve(NUM_VECTORS);
+		for (u32 vector_index = 0; vector_index < NUM_VECTORS; ++vector_index)
+		{
+			Vector<u32, Allocator>& vector = vectors.emplace_back(allocator);
+			for (u32 index = 0; index < NUM_ELEMENTS + vector_index % 8; ++index)
+			{
+				vector.push_back(index * vector_index);
+			}
+		}
+
+		aw::bench::do_not_optimize(vectors.back().back());
+	}
+} // namespace
+
+int main()
+{
+	aw::bench::run("scratch vectors, DefaultAllocator", 1, NUM_REQUESTS, [](u32) {
+		for (u64 request = 0; request < NUM_REQUESTS; ++request)
+		{
+			handle_request(DefaultAllocator<u32>());
+		}
+	});
+
+	aw::bench::run("scratch vectors, LinearArena", 1, NUM_REQUESTS, [](u32) {
+		LinearArena arena;
+		for (u64 request = 0; request < NUM_REQUESTS; ++request)
+		{
+			handle_request(ArenaAllocator<u32>(arena));
+			arena.reset();
+		}
+	});
+
+	return 0;
+}
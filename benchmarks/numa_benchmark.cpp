@@ -0,0 +1,67 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr usize ALLOCATION_SIZE = 4000;
+	constexpr u64	NUM_BLOCKS = 16'384;
+	constexpr u64	NUM_ROUNDS = 20;
+
+	// Runs on the first node and fills blocks of the page trees of 'node', with a working set of 64 MB so the accesses miss the caches.
+	// Every round allocates all blocks, writes and reads them back, and frees them again.
+	void run_fill(const std::string_view name, PagedMemoryPool& heap, const u32 node)
+	{
+		aw::bench::run(name, 1, NUM_BLOCKS * NUM_ROUNDS, [&heap, node](u32) {
+			Numa::run_on_node(0);
+			PageTree*		   tree = heap.get_page_tree(PagedMemoryPool::get_size_class_index(ALLOCATION_SIZE), node);
+			std::vector<void*> blocks(NUM_BLOCKS);
+			u64				   checksum = 0;
+			for (u64 round = 0; round < NUM_ROUNDS; ++round)
+			{
+				for (void*& block : blocks)
+				{
+					block = tree->allocate_block(ALLOCATION_SIZE);
+					std::memset(block, static_cast<int>(round), ALLOCATION_SIZE);
+				}
+
+				for (void* block : blocks)
+				{
+					checksum += static_cast<const u8*>(block)[ALLOCATION_SIZE / 2];
+					MemoryPage::free_block(block);
+				}
+			}
+			aw::bench::do_not_optimize(checksum);
+		});
+	}
+} // namespace
+
+int main()
+{
+	const u32 num_nodes = Numa::get_num_nodes();
+	std::printf("NUMA nodes: %u\n", num_nodes);
+
+	// Keep the drained pages, otherwise every round measures page faults instead of the accesses
+	PagedMemoryPool::set_max_empty_pages_per_class(64);
+	PagedMemoryPool::set_max_retained_bytes(Megabytes(256));
+
+	// A heap of its own, so the thread caches of the default heap don't hand out blocks of other nodes
+	PagedMemoryPool heap;
+	run_fill("4000 B blocks, local node", heap, 0);
+	if (num_nodes > 1)
+	{
+		run_fill("4000 B blocks, remote node", heap, num_nodes - 1);
+	}
+	else
+	{
+		std::printf("Single node, there is no remote memory to compare with\n");
+	}
+
+	return 0;
+}
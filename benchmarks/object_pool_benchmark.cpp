@@ -0,0 +1,72 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/intrusive_ref_counted.h"
+#include "aw/core/memory/object_pool.h"
+
+#include <array>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr u64 NUM_OPS = 2'000'000;
+	constexpr u32 NUM_LIVE = 128;
+
+	struct Object : IntrusiveRefCounted
+	{
+		u64 payload[6]{};
+	};
+
+	struct PooledObject : PooledRefCounted<PooledObject>
+	{
+		u64 payload[6]{};
+	};
+
+	// Keeps a window of live objects and replaces one of them per operation
+	template <typename CreateFn, typename DestroyFn>
+	void run_churn(const std::string_view name, const u32 num_threads, CreateFn create, DestroyFn destroy)
+	{
+		aw::bench::run(name, num_threads, NUM_OPS, [&](u32) {
+			std::array<decltype(create()), NUM_LIVE> live{};
+			for (u64 op = 0; op < NUM_OPS; ++op)
+			{
+				auto& slot = live[op % NUM_LIVE];
+				if (slot)
+					destroy(slot);
+
+				slot = create();
+				aw::bench::do_not_optimize(slot);
+			}
+
+			for (auto& object : live)
+			{
+				destroy(object);
+			}
+		});
+	}
+
+	template <typename T>
+	void run_ref_churn(const std::string_view name, const u32 num_threads)
+	{
+		aw::bench::run(name, num_threads, NUM_OPS, [](u32) {
+			std::array<RefPtr<T>, NUM_LIVE> live{};
+			for (u64 op = 0; op < NUM_OPS; ++op)
+			{
+				live[op % NUM_LIVE] = new_ref<T>();
+			}
+		});
+	}
+} // namespace
+
+int main()
+{
+	for (const u32 num_threads : { 1u, 4u })
+	{
+		run_churn("create+destroy, aw_new", num_threads, [] { return aw_new Object(); }, [](Object* object) { aw_delete(object); });
+		run_churn("create+destroy, ObjectPool", num_threads, [] { return ObjectPool<Object>::get().create(); }, [](Object* object) { ObjectPool<Object>::get().destroy(object); });
+		run_ref_churn<Object>("new_ref, IntrusiveRefCounted", num_threads);
+		run_ref_churn<PooledObject>("new_ref, PooledRefCounted", num_threads);
+	}
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+using namespace aw::core;
+
+namespace
+{
+	// The mutex-guarded free list that PageFreeList replaced. Kept here as the baseline.
+	struct MutexPageFreeList
+	{
+		static constexpr u32 CAPACITY_INCREMENT_NUMERATOR = 3;
+		static constexpr u32 CAPACITY_INCREMENT_DENOMINATOR = 2;
+
+		explicit MutexPageFreeList(const u32 preallocated_capacity = 1024)
+			: data(static_cast<u32*>(malloc(sizeof(u32) * preallocated_capacity)))
+			, capacity(preallocated_capacity)
+		{
+		}
+
+		~MutexPageFreeList()
+		{
+			free(data);
+		}
+
+		void push(const u32 index)
+		{
+			std::lock_guard lock(mutex);
+			if (size == capacity)
+			{
+				capacity = capacity * CAPACITY_INCREMENT_NUMERATOR / CAPACITY_INCREMENT_DENOMINATOR;
+				const auto new_block = static_cast<u32*>(malloc(capacity * sizeof(u32)));
+				std::memcpy(new_block, data, size * sizeof(u32));
+				free(data);
+				data = new_block;
+			}
+
+			data[size++] = index;
+		}
+
+		u32 pop()
+		{
+			std::lock_guard lock(mutex);
+			if (size == 0)
+				return PageFreeList::INVALID_INDEX;
+
+			return data[--size];
+		}
+
+		u32*	   data{};
+		u32		   capacity{};
+		u32		   size{};
+		std::mutex mutex{};
+	};
+
+	constexpr u32 NUM_BLOCKS = 4096;
+	constexpr u64 BLOCK_STRIDE = 64;
+	constexpr u64 NUM_OPS = 1'000'000;
+
+	alignas(64) std::array<u8, NUM_BLOCKS * BLOCK_STRIDE> g_Blocks{};
+
+	// Every thread pops a block and pushes it back, which is what a page sees under cross-thread alloc/free traffic.
+	template <typename FreeList>
+	void run_pop_push(const std::string_view name, FreeList& free_list, const u32 num_threads)
+	{
+		for (u32 index = 0; index < NUM_BLOCKS; ++index)
+		{
+			free_list.push(index);
+		}
+
+		aw::bench::run(name, num_threads, NUM_OPS, [&free_list](u32) {
+			for (u64 op = 0; op < NUM_OPS; ++op)
+			{
+				const u32 index = free_list.pop();
+				aw::bench::do_not_optimize(index);
+				if (index != PageFreeList::INVALID_INDEX)
+				{
+					free_list.push(index);
+				}
+			}
+		});
+
+		while (free_list.pop() != PageFreeList::INVALID_INDEX)
+		{
+		}
+	}
+} // namespace
+
+int main()
+{
+	for (const u32 num_threads : { 1u, 2u, 4u, 8u, 16u })
+	{
+		{
+			MutexPageFreeList free_list;
+			run_pop_push("MutexPageFreeList pop+push", free_list, num_threads);
+		}
+		{
+			PageFreeList free_list(g_Blocks.data(), BLOCK_STRIDE);
+			run_pop_push("PageFreeList (lock-free) pop+push", free_list, num_threads);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <vector>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr usize ALLOCATION_SIZE = 4000;
+	constexpr u64	NUM_CYCLES = 20'000;
+
+	// Keeps a page full and allocates and frees a single block on the next one, so the live set keeps crossing the page boundary.
+	void run_boundary_oscillation(const std::string_view name, const u32 max_empty_pages_per_class)
+	{
+		PagedMemoryPool::set_max_empty_pages_per_class(max_empty_pages_per_class);
+
+		PagedMemoryPool& pool = PagedMemoryPool::get();
+		PageTree*		 tree = pool.get_page_tree(PagedMemoryPool::get_size_class_index(ALLOCATION_SIZE));
+
+		std::vector<void*> allocations;
+		for (u64 index = 0; index < tree->get_blocks_per_page(); ++index)
+		{
+			allocations.push_back(pool.allocate_memory(ALLOCATION_SIZE));
+		}
+
+		aw::bench::run(name, 1, NUM_CYCLES, [&pool](u32) {
+			for (u64 cycle = 0; cycle < NUM_CYCLES; ++cycle)
+			{
+				void* block = pool.allocate_memory(ALLOCATION_SIZE);
+				aw::bench::do_not_optimize(block);
+				PagedMemoryPool::free_memory(block);
+			}
+		});
+
+		for (void* allocation : allocations)
+		{
+			PagedMemoryPool::free_memory(allocation);
+		}
+	}
+} // namespace
+
+int main()
+{
+	// Go straight to the pages, the thread cache would hide the page boundary
+	PagedMemoryPool::set_thread_cache_depth(0);
+
+	run_boundary_oscillation("page boundary alloc+free, no retention", 0);
+	run_boundary_oscillation("page boundary alloc+free, 1 retained page", 1);
+
+	return 0;
+}
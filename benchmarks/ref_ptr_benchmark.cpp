@@ -0,0 +1,76 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/intrusive_ref_counted.h"
+
+#include <array>
+#include <utility>
+
+using namespace aw::core;
+
+namespace
+{
+	constexpr u64 NUM_OPS = 20'000'000;
+	constexpr u32 NUM_SLOTS = 64;
+
+	struct VirtualObject : IntrusiveRefCounted
+	{
+		u64 payload{};
+	};
+
+	struct AtomicObject : RefCounted<AtomicObject, AtomicRefCount>
+	{
+		u64 payload{};
+	};
+
+	struct SingleThreadedObject : RefCounted<SingleThreadedObject, SingleThreadedRefCount>
+	{
+		u64 payload{};
+	};
+
+	// Every operation releases the pointer in a slot, copies the object and moves the copy into the slot, as containers of RefPtr do.
+	// Assigning the pointer a slot holds already would do nothing, so the slot is emptied first.
+	template <typename T>
+	void churn(const RefPtr<T>& object)
+	{
+		std::array<RefPtr<T>, NUM_SLOTS> slots{};
+		for (u64 op = 0; op < NUM_OPS; ++op)
+		{
+			RefPtr<T>& slot = slots[op % NUM_SLOTS];
+			slot.reset();
+			RefPtr<T> copy = object;
+			slot = std::move(copy);
+			aw::bench::do_not_optimize(slot);
+		}
+	}
+
+	// Each thread churns its own object, so the numbers show the cost of the count, not the contention on it
+	template <typename T>
+	void run_churn(const std::string_view name, const u32 num_threads)
+	{
+		aw::bench::run(name, num_threads, NUM_OPS, [](u32) { churn(new_ref<T>()); });
+	}
+
+	// All threads churn the same object
+	template <typename T>
+	void run_shared_churn(const std::string_view name, const u32 num_threads)
+	{
+		const RefPtr<T> object = new_ref<T>();
+		aw::bench::run(name, num_threads, NUM_OPS, [&object](u32) { churn(object); });
+	}
+} // namespace
+
+int main()
+{
+	run_churn<VirtualObject>("copy+move, IntrusiveRefCounted (virtual)", 1);
+	run_churn<AtomicObject>("copy+move, RefCounted<AtomicRefCount>", 1);
+	run_churn<SingleThreadedObject>("copy+move, RefCounted<SingleThreadedRefCount>", 1);
+
+	run_churn<VirtualObject>("copy+move, IntrusiveRefCounted (virtual)", 4);
+	run_churn<AtomicObject>("copy+move, RefCounted<AtomicRefCount>", 4);
+	run_churn<SingleThreadedObject>("copy+move, RefCounted<SingleThreadedRefCount>", 4);
+
+	run_shared_churn<VirtualObject>("shared copy+move, IntrusiveRefCounted", 4);
+	run_shared_churn<AtomicObject>("shared copy+move, RefCounted<AtomicRefCount>", 4);
+
+	return 0;
+}
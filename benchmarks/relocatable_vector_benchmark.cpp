@@ -0,0 +1,47 @@
+#include "benchmark.h"
+
+#include "aw/core/memory/memalloc.h"
+#include "aw/core/primitive/container_aliases.h"
+#include "aw/core/primitive/relocatable_vector.h"
+
+#include <string_view>
+
+using namespace aw::core;
+
+namespace
+{
+	struct Particle
+	{
+		f32 position[3]{};
+		f32 velocity[3]{};
+		u32 id{};
+	};
+
+	constexpr u64 NUM_ELEMENTS = 2'000'000;
+	constexpr u32 NUM_ROUNDS = 10;
+
+	// Fills a vector without reserving, so the time is dominated by how the buffer grows
+	template <typename VectorType>
+	void run_push_back(const std::string_view name)
+	{
+		aw::bench::run(name, 1, NUM_ELEMENTS * NUM_ROUNDS, [](u32) {
+			for (u32 round = 0; round < NUM_ROUNDS; ++round)
+			{
+				VectorType particles;
+				for (u64 index = 0; index < NUM_ELEMENTS; ++index)
+				{
+					particles.push_back(Particle{ .id = static_cast<u32>(index) });
+				}
+				aw::bench::do_not_optimize(particles.data());
+			}
+		});
+	}
+} // namespace
+
+int main()
+{
+	run_push_back<Vector<Particle>>("push_back, Vector");
+	run_push_back<RelocatableVector<Particle>>("push_back, RelocatableVector");
+
+	return 0;
+}
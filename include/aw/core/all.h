@@ -4,6 +4,8 @@
 
 #include "aw/core/primitive/numbers.h"
 #include "aw/core/primitive/container_aliases.h"
+#include "aw/core/primitive/flat_hash_map.h"
+#include "aw/core/primitive/relocatable_vector.h"
 #include "aw/core/primitive/defer.h"
 #include "aw/core/primitive/macros.h"
 #include "aw/core/primitive/enum_flags.h"
@@ -12,7 +14,18 @@
 
 #include "aw/core/memory/memalloc.h"
 #include "aw/core/memory/allocators.h"
+#include "aw/core/memory/linear_arena.h"
+#include "aw/core/memory/stack_allocator.h"
+#include "aw/core/memory/virtual_memory.h"
+#include "aw/core/memory/numa.h"
+#include "aw/core/memory/size_classes.h"
+#include "aw/core/memory/buddy_allocator.h"
+#include "aw/core/memory/pool_stats.h"
+#include "aw/core/memory/memory_tags.h"
+#include "aw/core/memory/heap_profiler.h"
 #include "aw/core/memory/paged_memory_pool.h"
+#include "aw/core/memory/thread_cache.h"
+#include "aw/core/memory/object_pool.h"
 #include "aw/core/memory/intrusive_ref_counted.h"
 
 #include "aw/core/math/math.h"
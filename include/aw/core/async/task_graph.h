@@ -2,6 +2,7 @@
 
 #include "thread_pool.h"
 #include "aw/core/memory/paged_memory_pool.h"
+#include "aw/core/memory/object_pool.h"
 #include "aw/core/primitive/container_aliases.h"
 
 namespace aw::core
@@ -58,7 +59,7 @@ namespace aw::core
 		{
 			void operator()(TaskNode* node) const
 			{
-				aw_delete(node);
+				ObjectPool<TaskNode>::get().destroy(node);
 			}
 		};
 
@@ -71,7 +72,7 @@ namespace aw::core
 		template<typename Fn>
 		TaskNode* add_task(Fn&& fn)
 		{
-			auto task = TaskNodePtr(aw_new TaskNode);
+			auto task = TaskNodePtr(ObjectPool<TaskNode>::get().create());
 			task->task = [func = std::move(fn)] { func(); };
 			const auto task_ptr = task.get();
 			task->parent = this;
@@ -1,8 +1,7 @@
 #pragma once
 
 #include "aw/core/filesystem/virtual_file_system.h"
-
-#include <unordered_map>
+#include "aw/core/primitive/flat_hash_map.h"
 
 namespace aw::core
 {
@@ -19,7 +18,7 @@ namespace aw::core
 		void try_init_mappings_from_awpk_manifest();
 
 	private:
-		std::unordered_map<std::string, std::string> m_Mappings;
+		StringMap<std::string> m_Mappings;
 	};
 	//
 }
\ No newline at end of file
@@ -383,5 +383,11 @@ namespace aw::core
 
 			return 1ull << count;
 		}
+
+		/** Rounds the value up to a multiple of the alignment. The alignment must be a power of two. */
+		static constexpr u64 align_up(const u64 value, const u64 alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
 	};
 } // namespace aw::core
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "memalloc.h"
+#include "memory_tags.h"
 #include <limits>
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
 
 namespace aw::core
 {
@@ -39,7 +44,8 @@ namespace aw::core
 			if (n > std::numeric_limits<usize>::max() / sizeof(T))
 				throw std::bad_array_new_length();
 
-			if (auto p = static_cast<T*>(allocate_memory(n * sizeof(T))))
+			void* memory = alignof(T) > alignof(std::max_align_t) ? allocate_memory_aligned(n * sizeof(T), alignof(T)) : allocate_memory(n * sizeof(T));
+			if (auto p = static_cast<T*>(memory))
 			{
 				return p;
 			}
@@ -50,7 +56,11 @@ namespace aw::core
 		// Deallocation
 		static void deallocate(T* p, usize n) noexcept
 		{
-			free_memory(p);
+			// The size tells the size class, unless the memory was over-aligned
+			if constexpr (alignof(T) > alignof(std::max_align_t))
+				free_memory(p);
+			else
+				free_memory(p, n * sizeof(T));
 		}
 	};
 
@@ -60,6 +70,186 @@ namespace aw::core
 		return true;
 	}
 
+	/**
+	 * DefaultAllocator over a heap other than the default one, e.g. to keep the containers of a subsystem from fragmenting the default heap.
+	 * Blocks find their heap through their page, so the memory is freed the same way as the memory of the DefaultAllocator.
+	 */
+	template <typename T>
+	class HeapAllocator
+	{
+	public:
+		using value_type = T;
+		using size_type = usize;
+		using difference_type = std::ptrdiff_t;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		HeapAllocator() noexcept
+			: m_Heap(&get_default_heap())
+		{
+		}
+
+		explicit HeapAllocator(PagedMemoryPool& heap) noexcept
+			: m_Heap(&heap)
+		{
+		}
+
+		template <typename U>
+		explicit HeapAllocator(const HeapAllocator<U>& other) noexcept
+			: m_Heap(&other.get_heap())
+		{
+		}
+
+		template <typename U>
+		struct rebind
+		{
+			using other = HeapAllocator<U>;
+		};
+
+		[[nodiscard]] T* allocate(usize n)
+		{
+			if (n > std::numeric_limits<usize>::max() / sizeof(T))
+				throw std::bad_array_new_length();
+
+			void* memory = alignof(T) > alignof(std::max_align_t) ? allocate_memory_aligned(*m_Heap, n * sizeof(T), alignof(T)) : allocate_memory(*m_Heap, n * sizeof(T));
+			if (auto p = static_cast<T*>(memory))
+			{
+				return p;
+			}
+
+			throw std::bad_alloc();
+		}
+
+		static void deallocate(T* p, usize n) noexcept
+		{
+			DefaultAllocator<T>::deallocate(p, n);
+		}
+
+		PagedMemoryPool& get_heap() const noexcept { return *m_Heap; }
+
+	private:
+		PagedMemoryPool* m_Heap;
+	};
+
+	template <typename T1, typename T2>
+	bool operator==(const HeapAllocator<T1>& lhs, const HeapAllocator<T2>& rhs) noexcept
+	{
+		return &lhs.get_heap() == &rhs.get_heap();
+	}
+
+	/**
+	 * DefaultAllocator over the heap of a memory tag, so the containers of a subsystem count against the live bytes and the budget of the tag.
+	 * Stateless: every allocator of the same tag allocates from the same heap.
+	 */
+	template <typename T, MemoryTag Tag>
+	class TaggedAllocator
+	{
+	public:
+		using value_type = T;
+		using size_type = usize;
+		using difference_type = std::ptrdiff_t;
+		using propagate_on_container_move_assignment = std::true_type;
+
+		using is_always_equal = std::true_type;
+
+		TaggedAllocator() noexcept = default;
+
+		template <typename U>
+		explicit TaggedAllocator(const TaggedAllocator<U, Tag>&) noexcept
+		{
+		}
+
+		template <typename U>
+		struct rebind
+		{
+			using other = TaggedAllocator<U, Tag>;
+		};
+
+		[[nodiscard]] T* allocate(usize n)
+		{
+			if (n > std::numeric_limits<usize>::max() / sizeof(T))
+				throw std::bad_array_new_length();
+
+			PagedMemoryPool& heap = MemoryTags::get_heap<Tag>();
+			void* memory = alignof(T) > alignof(std::max_align_t) ? allocate_memory_aligned(heap, n * sizeof(T), alignof(T)) : allocate_memory(heap, n * sizeof(T));
+			if (auto p = static_cast<T*>(memory))
+			{
+				return p;
+			}
+
+			throw std::bad_alloc();
+		}
+
+		static void deallocate(T* p, usize n) noexcept
+		{
+			DefaultAllocator<T>::deallocate(p, n);
+		}
+	};
+
+	template <typename T1, typename T2, typename Tag>
+	bool operator==(const TaggedAllocator<T1, Tag>&, const TaggedAllocator<T2, Tag>&) noexcept
+	{
+		return true;
+	}
+
+	/**
+	 * Allocator for the PagedMemoryPool, which aligns every allocation to at least 'Alignment' bytes.
+	 * E.g. for arrays used with aligned SIMD loads, or for elements padded to a cache line to avoid false sharing.
+	 */
+	template <typename T, usize Alignment>
+	class AlignedAllocator
+	{
+		static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two.");
+
+	public:
+		using value_type = T;
+		using size_type = usize;
+		using difference_type = std::ptrdiff_t;
+		using propagate_on_container_move_assignment = std::true_type;
+
+		using is_always_equal = std::true_type;
+
+		static constexpr usize alignment = Alignment > alignof(T) ? Alignment : alignof(T);
+
+		AlignedAllocator() noexcept = default;
+
+		template <typename U>
+		explicit AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+		{
+		}
+
+		template <typename U>
+		struct rebind
+		{
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+		[[nodiscard]] T* allocate(usize n)
+		{
+			if (n > std::numeric_limits<usize>::max() / sizeof(T))
+				throw std::bad_array_new_length();
+
+			if (auto p = static_cast<T*>(allocate_memory_aligned(n * sizeof(T), alignment)))
+			{
+				return p;
+			}
+
+			throw std::bad_alloc();
+		}
+
+		static void deallocate(T* p, usize) noexcept
+		{
+			free_memory(p);
+		}
+	};
+
+	template <typename T1, typename T2, usize Alignment>
+	bool operator==(const AlignedAllocator<T1, Alignment>&, const AlignedAllocator<T2, Alignment>&) noexcept
+	{
+		return true;
+	}
+
 	template <typename T, usize InlineCapacity = 1>
 	class InlineAllocator
 	{
@@ -146,6 +336,11 @@ namespace aw::core
 		}
 	};
 
+	/**
+	 * Allocator over a buffer that lives inside of the allocator, for containers that must not touch the heap.
+	 * The buffer is split into granules of sizeof(T) with a bit per granule, so a free only clears its bits and neighbouring free ranges
+	 * merge by themselves. Free ranges are searched a word of the bitmap at a time.
+	 */
 	template <typename T, usize BufferSize>
 	class StaticAllocator
 	{
@@ -153,9 +348,11 @@ namespace aw::core
 		using value_type = T;
 		using size_type = usize;
 		using difference_type = std::ptrdiff_t;
-		using propagate_on_container_move_assignment = std::true_type;
-		using propagate_on_container_copy_assignment = std::true_type;
-		using propagate_on_container_swap = std::true_type;
+
+		// Every allocator owns its buffer, so the memory can never move to another allocator
+		using propagate_on_container_move_assignment = std::false_type;
+		using propagate_on_container_copy_assignment = std::false_type;
+		using propagate_on_container_swap = std::false_type;
 		using is_always_equal = std::false_type;
 
 		template <typename U>
@@ -165,84 +362,140 @@ namespace aw::core
 		};
 
 	private:
-		struct Block
-		{
-			usize offset;
-			usize size;
-			bool  used;
-		};
+		static constexpr usize NUM_GRANULES = BufferSize / sizeof(T);
+		static constexpr usize NUM_WORDS = (NUM_GRANULES + 63) / 64;
 
 		alignas(T) std::array<std::byte, BufferSize> m_Buffer;
-		std::array<Block, BufferSize / sizeof(T)> m_Blocks;
-		usize									  m_BlockCount{ 0 };
 
-		Block* find_free_block(usize size)
+		// A set bit marks a used granule. The bits past the end of the buffer are always set.
+		std::array<u64, NUM_WORDS> m_UsedGranules{};
+
+		void reset_granules() noexcept
+		{
+			m_UsedGranules.fill(0);
+			if constexpr (NUM_GRANULES % 64 != 0)
+				m_UsedGranules.back() = ~0ull << (NUM_GRANULES % 64);
+		}
+
+		// Returns the first granule of the first free run of 'count' granules, or NUM_GRANULES if there is none.
+		usize find_free_granules(const usize count) const noexcept
 		{
-			for (usize i = 0; i < m_BlockCount; ++i)
+			usize run_start = 0;
+			usize run_length = 0;
+			for (usize word_index = 0; word_index < NUM_WORDS; ++word_index)
 			{
-				if (!m_Blocks[i].used && m_Blocks[i].size >= size)
+				const u64 used = m_UsedGranules[word_index];
+				if (used == ~0ull)
+				{
+					run_length = 0;
+					continue;
+				}
+
+				u32 bit = 0;
+				while (bit < 64)
 				{
-					return &m_Blocks[i];
+					const u64 remaining = used >> bit;
+					const u32 num_free = remaining == 0 ? 64 - bit : static_cast<u32>(std::countr_zero(remaining));
+					if (num_free > 0)
+					{
+						if (run_length == 0)
+							run_start = word_index * 64 + bit;
+
+						run_length += num_free;
+						if (run_length >= count)
+							return run_start;
+
+						bit += num_free;
+						if (bit >= 64)
+							break;
+					}
+
+					run_length = 0;
+					bit += static_cast<u32>(std::countr_one(used >> bit));
 				}
 			}
-			return nullptr;
+
+			return NUM_GRANULES;
+		}
+
+		void set_granules(const usize first, const usize count, const bool used) noexcept
+		{
+			usize granule = first;
+			const usize end = first + count;
+			while (granule < end)
+			{
+				const usize bit = granule % 64;
+				const usize num_bits = std::min<usize>(64 - bit, end - granule);
+				const u64	mask = (num_bits == 64 ? ~0ull : ((1ull << num_bits) - 1)) << bit;
+				if (used)
+					m_UsedGranules[granule / 64] |= mask;
+				else
+					m_UsedGranules[granule / 64] &= ~mask;
+
+				granule += num_bits;
+			}
 		}
 
 	public:
-		StaticAllocator() noexcept = default;
+		StaticAllocator() noexcept
+		{
+			reset_granules();
+		}
+
+		// Copies get a buffer of their own, the allocations of 'other' stay in its buffer
+		StaticAllocator(const StaticAllocator&) noexcept
+			: StaticAllocator()
+		{
+		}
 
 		template <typename U>
 		StaticAllocator(const StaticAllocator<U, BufferSize>&) noexcept
+			: StaticAllocator()
 		{
 		}
 
-		[[nodiscard]] T* allocate(const usize n)
+		// The buffer may still hold allocations, so it's never overwritten
+		StaticAllocator& operator=(const StaticAllocator&) noexcept
 		{
-			const usize size = n * sizeof(T);
-			if (size > BufferSize)
-			{
-				throw std::bad_alloc();
-			}
-
-			if (Block* block = find_free_block(size))
-			{
-				block->used = true;
-				return reinterpret_cast<T*>(&m_Buffer[block->offset]);
-			}
+			return *this;
+		}
 
-			if (m_BlockCount >= m_Blocks.size())
+		[[nodiscard]] T* allocate(const usize n)
+		{
+			if (n == 0 || n > NUM_GRANULES)
 			{
 				throw std::bad_alloc();
 			}
 
-			const usize offset = m_BlockCount > 0
-				? m_Blocks[m_BlockCount - 1].offset + m_Blocks[m_BlockCount - 1].size
-				: 0;
-
-			if (offset + size > BufferSize)
+			const usize first = find_free_granules(n);
+			if (first == NUM_GRANULES)
 			{
 				throw std::bad_alloc();
 			}
 
-			Block& newBlock = m_Blocks[m_BlockCount++];
-			newBlock.offset = offset;
-			newBlock.size = size;
-			newBlock.used = true;
-
-			return reinterpret_cast<T*>(&m_Buffer[offset]);
+			set_granules(first, n, true);
+			return reinterpret_cast<T*>(&m_Buffer[first * sizeof(T)]);
 		}
 
-		void deallocate(T* p, usize) noexcept
+		void deallocate(T* p, const usize n) noexcept
 		{
 			const usize offset = reinterpret_cast<std::byte*>(p) - m_Buffer.data();
-			for (usize i = 0; i < m_BlockCount; ++i)
+			assert(offset < BufferSize && offset % sizeof(T) == 0);
+			set_granules(offset / sizeof(T), n, false);
+		}
+
+		/** Number of elements in the largest allocation that would succeed right now. */
+		usize get_max_allocation() const noexcept
+		{
+			usize longest = 0;
+			usize current = 0;
+			for (usize granule = 0; granule < NUM_GRANULES; ++granule)
 			{
-				if (m_Blocks[i].offset == offset)
-				{
-					m_Blocks[i].used = false;
-					return;
-				}
+				current = (m_UsedGranules[granule / 64] >> (granule % 64)) & 1 ? 0 : current + 1;
+				longest = std::max(longest, current);
 			}
+
+			return longest;
 		}
 
 		bool operator==(const StaticAllocator& other) const noexcept
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+
+#include <array>
+#include <bit>
+#include <mutex>
+
+namespace aw::core
+{
+	class MemoryPage;
+
+	struct BuddyStats
+	{
+		static constexpr u64 NUM_ORDERS = 5;
+
+		// 64 MB reservations the blocks are carved from
+		u64 num_arenas{};
+
+		// Memory of the tier backed by physical pages, for live and free blocks together
+		u64 committed_bytes{};
+
+		u64 live_allocations{};
+		u64 total_allocations{};
+
+		// Allocations that got a block that was committed already, without asking the OS for memory
+		u64 recycled_allocations{};
+
+		// Size of the live blocks and of the blocks waiting in the free lists
+		u64 live_block_bytes{};
+		u64 free_block_bytes{};
+
+		// Free blocks of 4, 8, 16, 32 and 64 MB
+		std::array<u64, NUM_ORDERS> free_blocks{};
+	};
+
+	/**
+	 * Binary buddy allocator for the chunks of allocations that don't fit into a page.
+	 * Blocks of 4 MB to 64 MB are split from 64 MB arenas. Freed blocks keep their committed memory and go to the free list of their size,
+	 * so a workload that keeps allocating big buffers reuses them without going to the OS.
+	 * Free buddies are only merged when an allocation finds no block that is big enough, and by trim().
+	 * Only trim() gives the memory back, apart from arenas that drained completely while another one is free already.
+	 *
+	 * Every block starts with a MemoryPage, like any other chunk, so allocations of the tier are found and freed by masking their address.
+	 * The allocator is driven by the PagedMemoryPool and takes a single lock, which is fine for allocations of this size.
+	 */
+	class BuddyAllocator
+	{
+	public:
+		static constexpr u64 MIN_BLOCK_SIZE = 4 * 1024 * 1024;
+		static constexpr u64 MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+		static constexpr u64 NUM_ORDERS = std::countr_zero(MAX_BLOCK_SIZE / MIN_BLOCK_SIZE) + 1;
+
+		static_assert(NUM_ORDERS == BuddyStats::NUM_ORDERS);
+
+		constexpr BuddyAllocator() = default;
+
+		/** Whether a chunk of 'chunk_size' bytes is served by the tier. */
+		static constexpr bool fits(const u64 chunk_size) { return chunk_size <= MAX_BLOCK_SIZE; }
+
+		/** Size of the block a chunk of 'chunk_size' bytes gets. */
+		static constexpr u64 get_block_size(const u64 chunk_size) { return get_order_size(get_order(chunk_size)); }
+
+		/**
+		 * Returns a block with the page of a large allocation of 'used_size' bytes constructed at its start.
+		 * Everything up to 'used_size' is committed. Returns nullptr if the OS is out of memory.
+		 */
+		MemoryPage* allocate(u64 used_size);
+
+		/** Takes back a block returned by allocate(). */
+		void free(MemoryPage* page);
+
+		/** Commits the block of 'page' up to 'used_size', which must not be bigger than the block, when an allocation grows in place. */
+		bool commit(MemoryPage* page, u64 used_size);
+
+		/** Decommits the free blocks down to their first OS page and releases the arenas that are completely free. Returns the number of released bytes. */
+		u64 trim();
+
+		BuddyStats stats() const;
+
+	private:
+		static constexpr u64 get_order(const u64 size)
+		{
+			return size <= MIN_BLOCK_SIZE ? 0 : std::bit_width((size - 1) / MIN_BLOCK_SIZE);
+		}
+
+		static constexpr u64 get_order_size(const u64 order) { return MIN_BLOCK_SIZE << order; }
+
+		MemoryPage* create_arena();
+
+		// Returns the smallest order of at least 'order' that has a free block, NUM_ORDERS if there is none. Expects the lock to be held.
+		u64 find_free_order(u64 order) const;
+
+		// Merges all free blocks whose buddy is free as well. Returns whether any blocks were merged. Expects the lock to be held.
+		bool coalesce();
+
+		// Merges two free buddies, which are out of the free lists already, into a block of the next order. Expects the lock to be held.
+		void merge_blocks(MemoryPage* lower, MemoryPage* upper, u64 order);
+
+		// Turns the memory at 'address' into a free block. Expects the lock to be held.
+		MemoryPage* make_free_block(void* address, u64 block_size, u64 committed_size);
+
+		void push_free_block(MemoryPage* block, u64 order);
+
+		void remove_free_block(MemoryPage* block, u64 order);
+
+		mutable std::mutex					 m_Mutex{};
+		std::array<MemoryPage*, NUM_ORDERS> m_FreeBlocks{};
+		std::array<u64, NUM_ORDERS>			 m_NumFreeBlocks{};
+		u64									 m_NumArenas{};
+		u64									 m_CommittedBytes{};
+		u64									 m_LiveAllocations{};
+		u64									 m_TotalAllocations{};
+		u64									 m_RecycledAllocations{};
+		u64									 m_LiveBlockBytes{};
+	};
+} // namespace aw::core
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace aw::core
+{
+	/**
+	 * Sampling heap profiler of the PagedMemoryPool.
+	 * Every thread counts down the bytes it allocates, and the allocation that crosses zero gets its call stack recorded.
+	 * The countdown is drawn from an exponential distribution with the sample interval as its mean, so on average one sample is taken
+	 * for every 'interval' bytes, and small and big allocations are sampled proportionally to their size.
+	 * The cost of an allocation that isn't sampled is a thread-local subtraction.
+	 *
+	 * Live samples are grouped by their call stack in get_live_call_sites() and dump(). They are dumped to stderr when the process
+	 * exits with samples still alive, which points at the leaks.
+	 */
+	class HeapProfiler
+	{
+	public:
+		static constexpr u64 DEFAULT_SAMPLE_INTERVAL = 2 * 1024 * 1024;
+		static constexpr u32 MAX_FRAMES = 32;
+
+		struct CallSite
+		{
+			std::array<void*, MAX_FRAMES> frames{};
+			u32							  num_frames{};
+
+			u64 num_samples{};
+			u64 sampled_bytes{};
+
+			// Live bytes the samples stand for, including the allocations that weren't sampled
+			u64 estimated_bytes{};
+		};
+
+		/**
+		 * Sets the mean number of allocated bytes between two samples. 0 disables the profiler, which is the default.
+		 * The calling thread uses the new interval right away, other threads pick it up within their next 64 KB of allocations.
+		 */
+		static void set_sample_interval(u64 interval);
+
+		static u64 get_sample_interval() { return s_SampleInterval.load(std::memory_order::relaxed); }
+
+		static u64 get_num_live_samples() { return s_NumLiveSamples.load(std::memory_order::relaxed); }
+
+		/** Returns the live samples grouped by their call stack, the sites with the most estimated bytes first. */
+		static std::vector<CallSite> get_live_call_sites();
+
+		/** Returns a human-readable report of the live call sites, with symbol names where the platform can resolve them. */
+		static std::string dump();
+
+		/** Counts the allocation against the countdown of the thread. Returns true if it has to be recorded. */
+		static bool should_sample(const u64 size)
+		{
+			if (t_BytesUntilSample > size) [[likely]]
+			{
+				t_BytesUntilSample -= size;
+				return false;
+			}
+
+			return on_countdown_expired();
+		}
+
+		/** Records the call stack of a sampled allocation. 'key' identifies the allocation in record_free(). */
+		static void record_allocation(const void* key, u64 size);
+
+		/** Forgets the sample of the allocation. Returns false if the allocation wasn't sampled. */
+		static bool record_free(const void* key);
+
+	private:
+		static bool on_countdown_expired();
+
+		static inline thread_local u64 t_BytesUntilSample{};
+
+		static inline std::atomic<u64> s_SampleInterval{};
+		static inline std::atomic<u64> s_NumLiveSamples{};
+	};
+} // namespace aw::core
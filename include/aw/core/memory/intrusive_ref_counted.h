@@ -1,33 +1,202 @@
 #pragma once
 
 #include "paged_memory_pool.h"
+#include "object_pool.h"
 #include "aw/core/primitive/numbers.h"
 
 #include <atomic>
+#include <type_traits>
+#include <utility>
 
 namespace aw::core
 {
 	template <typename T>
 	class RefPtr;
 
+	class WeakRefControlBlock;
+
 	class IntrusiveRefCounted
 	{
 	public:
-		virtual ~IntrusiveRefCounted() = default;
+		virtual ~IntrusiveRefCounted();
 
 		virtual void add_ref() const;
 		virtual void release() const;
 		usize get_ref_count() const;
 
+		/** Adds a reference, unless the last one is gone already. This is how a weak reference turns into a strong one. */
+		bool try_add_ref() const;
+
+		/** Returns the block the weak references to the object share. It is taken from an ObjectPool when the first one is made. */
+		WeakRefControlBlock* get_weak_control_block() const;
+
+	protected:
+		// Called by the last release(). Frees the object with aw_delete, unless it lives somewhere else.
+		virtual void destroy() const;
+
+	private:
+		mutable std::atomic<usize>				  m_RefCount{ 1 };
+		mutable std::atomic<WeakRefControlBlock*> m_WeakControlBlock{};
+	};
+
+	/**
+	 * Shared by the weak references to an IntrusiveRefCounted object, and outlives the object while any of them is left.
+	 * The object holds a weak reference of its own, which it drops when it's destroyed.
+	 */
+	class WeakRefControlBlock
+	{
+	public:
+		explicit WeakRefControlBlock(const IntrusiveRefCounted* object) noexcept
+			: m_Object(object)
+		{
+		}
+
+		/**
+		 * Adds a strong reference to the object if it's still alive. Lock-free: the object only waits for the upgrades that are
+		 * running while it is being destroyed, and those see that its last reference is gone.
+		 */
+		bool try_lock() const;
+
+		/** Whether the object is destroyed. An object whose last reference is being released right now may not count as expired yet. */
+		bool is_expired() const { return m_Object.load(std::memory_order::acquire) == nullptr; }
+
+		void add_weak_ref() { m_NumWeakRefs.fetch_add(1, std::memory_order::relaxed); }
+
+		/** Drops a weak reference. The last one gives the block back to its pool. */
+		void release_weak_ref();
+
 	private:
-		mutable std::atomic<usize> m_RefCount{ 1 };
+		friend class IntrusiveRefCounted;
+
+		// Called by the object before its memory goes away. Waits for the upgrades that may still read the reference count.
+		void expire();
+
+		std::atomic<const IntrusiveRefCounted*> m_Object;
+		mutable std::atomic<u32>				m_NumLocking{};
+		std::atomic<usize>						m_NumWeakRefs{ 1 };
+	};
+
+	/**
+	 * Base for ref counted types that live in the ObjectPool of their type instead of the PagedMemoryPool.
+	 * new_ref<Derived>() takes them from the pool, and the last release puts them back.
+	 */
+	template <typename Derived, typename Base = IntrusiveRefCounted>
+	class PooledRefCounted : public Base
+	{
+	public:
+		using PooledType = Derived;
+
+		using Base::Base;
+
+	protected:
+		void destroy() const override
+		{
+			ObjectPool<Derived>::get().destroy(static_cast<Derived*>(const_cast<PooledRefCounted*>(this)));
+		}
+	};
+
+	/** Reference count that can be shared between threads. */
+	class AtomicRefCount
+	{
+	public:
+		void increment() noexcept { m_Count.fetch_add(1, std::memory_order::relaxed); }
+
+		/** Returns true if the count dropped to zero. */
+		bool decrement() noexcept { return m_Count.fetch_sub(1, std::memory_order::acq_rel) == 1; }
+
+		usize get() const noexcept { return m_Count.load(std::memory_order::acquire); }
+
+	private:
+		std::atomic<usize> m_Count{ 1 };
+	};
+
+	/** Plain reference count for objects that never leave the thread that created them, e.g. the caches of a worker. */
+	class SingleThreadedRefCount
+	{
+	public:
+		void increment() noexcept { ++m_Count; }
+
+		/** Returns true if the count dropped to zero. */
+		bool decrement() noexcept { return --m_Count == 0; }
+
+		usize get() const noexcept { return m_Count; }
+
+	private:
+		usize m_Count{ 1 };
+	};
+
+	/**
+	 * Base for ref counted types without virtual calls: add_ref() and release() are inline, and RefPtr calls them directly.
+	 * 'CountPolicy' picks between an AtomicRefCount and a SingleThreadedRefCount at compile time.
+	 * The last release destroys the object as 'Derived'. Types that declare 'using PooledType = Derived;' go back to their ObjectPool,
+	 * the others are freed with aw_delete. RefPtr needs the complete type wherever it copies or destroys such a pointer.
+	 */
+	template <typename Derived, typename CountPolicy = AtomicRefCount>
+	class RefCounted
+	{
+	public:
+		using RefCountPolicy = CountPolicy;
+
+		void add_ref() const noexcept { m_RefCount.increment(); }
+
+		void release() const
+		{
+			if (m_RefCount.decrement())
+				destroy();
+		}
+
+		usize get_ref_count() const noexcept { return m_RefCount.get(); }
+
+	protected:
+		RefCounted() noexcept = default;
+
+		// A copy is another object, with a count of its own
+		RefCounted(const RefCounted&) noexcept {}
+		RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+
+		~RefCounted() = default;
+
+	private:
+		void destroy() const
+		{
+			Derived* object = static_cast<Derived*>(const_cast<RefCounted*>(this));
+			if constexpr (requires { typename Derived::PooledType; })
+			{
+				ObjectPool<Derived>::get().destroy(object);
+			}
+			else
+			{
+				aw_delete(object);
+			}
+		}
+
+		mutable CountPolicy m_RefCount{};
 	};
 
 	namespace detail
 	{
 		void fwd_ref_ptr_add_ref(void* ptr);
 		void fwd_ref_ptr_release(void* ptr);
-	}
+
+		// Types of RefCounted are counted inline, IntrusiveRefCounted goes through its virtual functions out of line
+		template <typename T>
+		void ref_ptr_add_ref(T* ptr)
+		{
+			if constexpr (requires { typename T::RefCountPolicy; })
+				ptr->add_ref();
+			else
+				fwd_ref_ptr_add_ref(ptr);
+		}
+
+		template <typename T>
+		void ref_ptr_release(T* ptr)
+		{
+			if constexpr (requires { typename T::RefCountPolicy; })
+				ptr->release();
+			else
+				fwd_ref_ptr_release(ptr);
+		}
+	} // namespace detail
 
 	template <typename T>
 	class RefPtr
@@ -48,7 +217,7 @@ namespace aw::core
 			m_Ptr = other.m_Ptr;
 			if (m_Ptr)
 			{
-				detail::fwd_ref_ptr_add_ref(m_Ptr);
+				detail::ref_ptr_add_ref(m_Ptr);
 			}
 		}
 		RefPtr(RefPtr&& other) noexcept
@@ -59,13 +228,13 @@ namespace aw::core
 			: m_Ptr(other.get())
 		{
 			if (m_Ptr)
-				detail::fwd_ref_ptr_add_ref(m_Ptr);
+				detail::ref_ptr_add_ref(m_Ptr);
 		}
 
 		~RefPtr()
 		{
 			if (m_Ptr)
-				detail::fwd_ref_ptr_release(m_Ptr);
+				detail::ref_ptr_release(m_Ptr);
 		}
 
 		RefPtr& operator=(const RefPtr& other) noexcept
@@ -73,10 +242,10 @@ namespace aw::core
 			if (get() != static_cast<T*>(other.get()))
 			{
 				if (m_Ptr)
-					detail::fwd_ref_ptr_release(m_Ptr);
+					detail::ref_ptr_release(m_Ptr);
 				m_Ptr = other.m_Ptr;
 				if (m_Ptr)
-					detail::fwd_ref_ptr_add_ref(m_Ptr);
+					detail::ref_ptr_add_ref(m_Ptr);
 			}
 			return *this;
 		}
@@ -86,7 +255,7 @@ namespace aw::core
 			if (get() != static_cast<T*>(other.get()))
 			{
 				if (m_Ptr)
-					detail::fwd_ref_ptr_release(m_Ptr);
+					detail::ref_ptr_release(m_Ptr);
 				m_Ptr = other.m_Ptr;
 				other.m_Ptr = nullptr;
 			}
@@ -99,10 +268,10 @@ namespace aw::core
 			if (get() != static_cast<T*>(other.get()))
 			{
 				if (m_Ptr)
-					detail::fwd_ref_ptr_release(m_Ptr);
+					detail::ref_ptr_release(m_Ptr);
 				m_Ptr = other.get();
 				if (m_Ptr)
-					detail::fwd_ref_ptr_add_ref(m_Ptr);
+					detail::ref_ptr_add_ref(m_Ptr);
 			}
 			return *this;
 		}
@@ -113,7 +282,7 @@ namespace aw::core
 			if (get() != static_cast<T*>(other.get()))
 			{
 				if (m_Ptr)
-					detail::fwd_ref_ptr_release(m_Ptr);
+					detail::ref_ptr_release(m_Ptr);
 				m_Ptr = other.get();
 				other.m_Ptr = nullptr;
 			}
@@ -130,14 +299,14 @@ namespace aw::core
 		void reset()
 		{
 			if (m_Ptr)
-				detail::fwd_ref_ptr_release(m_Ptr);
+				detail::ref_ptr_release(m_Ptr);
 			m_Ptr = nullptr;
 		}
 
 		T** release_and_get_address() noexcept
 		{
 			if (m_Ptr)
-				detail::fwd_ref_ptr_release(m_Ptr);
+				detail::ref_ptr_release(m_Ptr);
 			return &m_Ptr;
 		}
 
@@ -152,10 +321,105 @@ namespace aw::core
 		T* m_Ptr{};
 	};
 
+	/**
+	 * Weak reference to an IntrusiveRefCounted object, which doesn't keep it alive, e.g. for caches that drop what nobody else uses.
+	 * lock() returns a RefPtr to the object while it's alive, and an empty one after its last RefPtr is gone.
+	 */
+	template <typename T>
+	class WeakRefPtr
+	{
+	public:
+		WeakRefPtr() noexcept = default;
+
+		WeakRefPtr(std::nullptr_t) noexcept {}
+
+		WeakRefPtr(T* ptr)
+			: m_Ptr(ptr)
+		{
+			if (m_Ptr)
+			{
+				m_ControlBlock = m_Ptr->get_weak_control_block();
+				m_ControlBlock->add_weak_ref();
+			}
+		}
+
+		WeakRefPtr(const RefPtr<T>& other)
+			: WeakRefPtr(other.get())
+		{
+		}
+
+		WeakRefPtr(const WeakRefPtr& other) noexcept
+			: m_Ptr(other.m_Ptr)
+			, m_ControlBlock(other.m_ControlBlock)
+		{
+			if (m_ControlBlock)
+				m_ControlBlock->add_weak_ref();
+		}
+
+		WeakRefPtr(WeakRefPtr&& other) noexcept
+			: m_Ptr(std::exchange(other.m_Ptr, nullptr))
+			, m_ControlBlock(std::exchange(other.m_ControlBlock, nullptr))
+		{
+		}
+
+		~WeakRefPtr() { reset(); }
+
+		WeakRefPtr& operator=(const WeakRefPtr& other) noexcept
+		{
+			WeakRefPtr copy(other);
+			swap(copy);
+			return *this;
+		}
+
+		WeakRefPtr& operator=(WeakRefPtr&& other) noexcept
+		{
+			WeakRefPtr moved(std::move(other));
+			swap(moved);
+			return *this;
+		}
+
+		void swap(WeakRefPtr& other) noexcept
+		{
+			std::swap(m_Ptr, other.m_Ptr);
+			std::swap(m_ControlBlock, other.m_ControlBlock);
+		}
+
+		/** Returns a strong reference to the object, or an empty one if it's gone. */
+		RefPtr<T> lock() const
+		{
+			// RefPtr takes over the reference that try_lock() added
+			return m_ControlBlock && m_ControlBlock->try_lock() ? RefPtr<T>(m_Ptr) : RefPtr<T>();
+		}
+
+		bool is_expired() const { return !m_ControlBlock || m_ControlBlock->is_expired(); }
+
+		void reset() noexcept
+		{
+			if (m_ControlBlock)
+				m_ControlBlock->release_weak_ref();
+
+			m_Ptr = nullptr;
+			m_ControlBlock = nullptr;
+		}
+
+	private:
+		// Only dereferenced once a strong reference keeps the object alive
+		T*					 m_Ptr{};
+		WeakRefControlBlock* m_ControlBlock{};
+	};
+
 	template<typename T, typename ... Args>
 	T* new_ref_counted(Args&& ... args)
 	{
-		return aw_new T(std::forward<Args>(args)...);
+		if constexpr (requires { typename T::PooledType; })
+		{
+			static_assert(std::is_same_v<typename T::PooledType, T>, "The pool of the base would be too small for the type. Derive it from PooledRefCounted<T, Base> instead.");
+			return ObjectPool<T>::get().create(std::forward<Args>(args)...);
+		}
+		else
+		{
+			return aw_new T(std::forward<Args>(args)...);
+		}
 	}
 
 	template<typename T, typename ... Args>
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+#include "aw/core/math/math.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace aw::core
+{
+	/**
+	 * Bump-pointer allocator over chunks taken from the PagedMemoryPool.
+	 * Single allocations can't be freed, everything is thrown away at once with reset(), which only rewinds to the first chunk.
+	 * The chunks stay with the arena, so a reused arena stops allocating from the pool once it grew to the size of the workload.
+	 * Not thread-safe, an arena is meant to be owned by a single request or frame.
+	 */
+	class LinearArena
+	{
+		struct Chunk;
+
+	public:
+		static constexpr usize DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+		/** Position in the arena, see get_marker(). */
+		struct Marker
+		{
+			Chunk* chunk{};
+			u8*	   cursor{};
+		};
+
+		explicit LinearArena(usize chunk_size = DEFAULT_CHUNK_SIZE);
+
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		/** Returns 'size' bytes aligned to 'alignment' (a power of two), or nullptr if the pool is out of memory. */
+		[[nodiscard]] void* allocate(const usize size, const usize alignment = alignof(std::max_align_t))
+		{
+			// Compared as integers, so an arena without a chunk (both pointers null) and huge sizes fall through to the slow path
+			const auto cursor = reinterpret_cast<std::uintptr_t>(m_Cursor);
+			const auto end = reinterpret_cast<std::uintptr_t>(m_End);
+			const auto aligned = static_cast<std::uintptr_t>(Math::align_up(cursor, alignment));
+			if (aligned <= end && size <= end - aligned && cursor != 0) [[likely]]
+			{
+				m_Cursor = reinterpret_cast<u8*>(aligned + size);
+				return reinterpret_cast<void*>(aligned);
+			}
+
+			return allocate_from_next_chunk(size, alignment);
+		}
+
+		/** Frees all allocations in O(1). The chunks are kept and reused by the next allocations. */
+		void reset();
+
+		/** Returns the current position. Passing it to rewind() frees everything allocated after it. */
+		Marker get_marker() const { return { m_CurrentChunk, m_Cursor }; }
+
+		/** Frees all allocations made after the marker was taken, in O(1). Markers taken after it become invalid. */
+		void rewind(Marker marker);
+
+		/** Frees all allocations and returns the chunks to the pool. */
+		void release();
+
+		/** Size of all chunks owned by the arena. */
+		usize get_reserved_bytes() const { return m_ReservedBytes; }
+
+		usize get_chunk_size() const { return m_ChunkSize; }
+
+	private:
+		struct Chunk
+		{
+			Chunk* next{};
+			usize  size{};
+
+			u8* get_begin() { return reinterpret_cast<u8*>(this) + Math::align_up(sizeof(Chunk), alignof(std::max_align_t)); }
+			u8* get_end() { return reinterpret_cast<u8*>(this) + size; }
+		};
+
+		void* allocate_from_next_chunk(usize size, usize alignment);
+
+		void use_chunk(Chunk* chunk);
+
+		Chunk* m_FirstChunk{};
+		Chunk* m_CurrentChunk{};
+		u8*	   m_Cursor{};
+		u8*	   m_End{};
+		usize  m_ChunkSize{};
+		usize  m_ReservedBytes{};
+	};
+
+	/**
+	 * STL allocator that allocates from a LinearArena, e.g. Vector<T, ArenaAllocator<T>>.
+	 * deallocate() does nothing, the memory comes back when the arena is reset, so the containers must not outlive the reset.
+	 */
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+		using size_type = usize;
+		using difference_type = std::ptrdiff_t;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+		using is_always_equal = std::false_type;
+
+		ArenaAllocator(LinearArena& arena) noexcept
+			: m_Arena(&arena)
+		{
+		}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+			: m_Arena(other.get_arena())
+		{
+		}
+
+		template <typename U>
+		struct rebind
+		{
+			using other = ArenaAllocator<U>;
+		};
+
+		[[nodiscard]] T* allocate(const usize n)
+		{
+			if (n > std::numeric_limits<usize>::max() / sizeof(T))
+				throw std::bad_array_new_length();
+
+			if (auto p = static_cast<T*>(m_Arena->allocate(n * sizeof(T), alignof(T))))
+			{
+				return p;
+			}
+
+			throw std::bad_alloc();
+		}
+
+		static void deallocate(T*, usize) noexcept
+		{
+		}
+
+		LinearArena* get_arena() const noexcept { return m_Arena; }
+
+	private:
+		LinearArena* m_Arena{};
+	};
+
+	template <typename T1, typename T2>
+	bool operator==(const ArenaAllocator<T1>& lhs, const ArenaAllocator<T2>& rhs) noexcept
+	{
+		return lhs.get_arena() == rhs.get_arena();
+	}
+} // namespace aw::core
@@ -4,12 +4,35 @@
 
 namespace aw::core
 {
+	class PagedMemoryPool;
+
 	/** Allocates memory on the heap */
 	extern void* allocate_memory(usize size);
 
+	/** Allocates memory on the heap, aligned to 'alignment' (a power of two). Freed with free_memory() */
+	extern void* allocate_memory_aligned(usize size, usize alignment);
+
+	/** Allocates memory on 'heap' instead of the default heap. Freed with free_memory() like any other allocation */
+	extern void* allocate_memory(PagedMemoryPool& heap, usize size);
+
+	/** Allocates memory on 'heap', aligned to 'alignment' (a power of two). Freed with free_memory() */
+	extern void* allocate_memory_aligned(PagedMemoryPool& heap, usize size, usize alignment);
+
+	/** Returns the heap allocate_memory() allocates from */
+	extern PagedMemoryPool& get_default_heap();
+
 	/** Frees memory on the heap */
 	extern void free_memory(void* ptr);
 
+	/** Frees memory returned by allocate_memory() or reallocate_memory(), 'size' being the size that was asked for. Skips looking up the size class. */
+	extern void free_memory(void* ptr, usize size);
+
+	/** Resizes memory returned by allocate_memory(), in place if possible, like realloc(). Returns nullptr and keeps the memory if it fails. */
+	extern void* reallocate_memory(void* ptr, usize new_size);
+
 	/** Returns the size of the allocation */
 	extern usize get_allocation_size(void* ptr);
+
+	/** Returns the number of bytes that can be written to the allocation, which can be more than was asked for */
+	extern usize get_usable_allocation_size(void* ptr);
 } // namespace aw::core
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+
+#include <concepts>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aw::core
+{
+	class PagedMemoryPool;
+
+	/**
+	 * Type naming a subsystem whose memory is accounted on its own, e.g.
+	 *     struct VfsCacheTag { static constexpr std::string_view name = "vfs_cache"; };
+	 */
+	template <typename Tag>
+	concept MemoryTag = requires {
+		{ Tag::name } -> std::convertible_to<std::string_view>;
+	};
+
+	struct MemoryTagStats
+	{
+		std::string_view name{};
+		u64				 live_bytes{};
+		u64				 peak_live_bytes{};
+		u64				 budget{};
+		u64				 num_budget_failures{};
+	};
+
+	/**
+	 * Every memory tag allocates from a heap of its own, which counts the live bytes of the tag and can cap them with a budget
+	 * (PagedMemoryPool::set_budget()). The heap of a tag is created on first use and never destroyed, like the default heap.
+	 * The heaps of the tags aren't served by the thread caches, so every allocation locks the page tree of its size class.
+	 */
+	class MemoryTags
+	{
+	public:
+		template <MemoryTag Tag>
+		static PagedMemoryPool& get_heap()
+		{
+			static PagedMemoryPool& heap = create_heap(Tag::name);
+			return heap;
+		}
+
+		/** Counters of all tags that were used so far, in the order they were first used. */
+		static std::vector<MemoryTagStats> stats();
+
+		/** Human-readable table of stats(). */
+		static std::string to_string();
+
+	private:
+		static PagedMemoryPool& create_heap(std::string_view name);
+	};
+} // namespace aw::core
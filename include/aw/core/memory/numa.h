@@ -0,0 +1,31 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+
+namespace aw::core
+{
+	/**
+	 * Queries the NUMA topology of the machine and places memory on its nodes, without depending on libnuma.
+	 * Machines without NUMA report a single node, and placing memory on it does nothing.
+	 */
+	struct Numa
+	{
+		/** Nodes beyond this are folded onto the first ones. */
+		static constexpr u32 MAX_NODES = 8;
+
+		/** Returns the number of nodes, at least 1 and at most MAX_NODES. */
+		static u32 get_num_nodes();
+
+		/** Returns the node of the CPU the calling thread runs on. The thread may move to another node right after. */
+		static u32 get_current_node();
+
+		/**
+		 * Asks the OS to back the range with memory of 'node' once it's touched, falling back to other nodes when the node runs out of memory (mbind).
+		 * Returns false where memory can't be bound, it's placed on the node of the thread that touches it first then.
+		 */
+		static bool bind(void* address, u64 size, u32 node);
+
+		/** Restricts the calling thread to the CPUs of 'node'. Returns false if the node has no CPUs or the OS doesn't support it. */
+		static bool run_on_node(u32 node);
+	};
+} // namespace aw::core
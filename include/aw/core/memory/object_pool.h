@@ -0,0 +1,244 @@
+#pragma once
+
+#include "aw/core/memory/memalloc.h"
+#include "aw/core/math/math.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace aw::core
+{
+	/**
+	 * Pool of objects of a single type.
+	 * The objects live in contiguous slabs taken from the PagedMemoryPool, and a dead object stores the link of the free list in its own storage,
+	 * so an allocation is a pop from the list without any header or size class lookup.
+	 * Slabs are only returned when the pool is destroyed.
+	 *
+	 * Pools are thread-safe. The pool returned by get() also keeps a small free list per thread in front of the shared one,
+	 * so most allocations and frees of a thread don't take the lock.
+	 */
+	template <typename T>
+	class ObjectPool
+	{
+	public:
+		static constexpr usize DEFAULT_SLAB_SIZE = 64 * 1024;
+		static constexpr u32   THREAD_CACHE_SIZE = 64;
+
+		explicit ObjectPool(const usize slab_size = DEFAULT_SLAB_SIZE)
+			: ObjectPool(slab_size, false)
+		{
+		}
+
+		~ObjectPool()
+		{
+			while (Slab* slab = m_Slabs)
+			{
+				m_Slabs = slab->next;
+				free_memory(slab);
+			}
+		}
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		/** Returns the pool of the type, which is never destroyed, and uses thread-local caches. */
+		static ObjectPool& get()
+		{
+			static ObjectPool* pool = new ObjectPool(DEFAULT_SLAB_SIZE, true);
+			return *pool;
+		}
+
+		template <typename... Args>
+		[[nodiscard]] T* create(Args&&... args)
+		{
+			void* memory = allocate();
+			if (!memory)
+				throw std::bad_alloc();
+
+			try
+			{
+				return std::construct_at(static_cast<T*>(memory), std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				deallocate(memory);
+				throw;
+			}
+		}
+
+		void destroy(T* object)
+		{
+			if (!object)
+				return;
+
+			std::destroy_at(object);
+			deallocate(object);
+		}
+
+		/** Returns uninitialized storage for a T, or nullptr if the PagedMemoryPool is out of memory. */
+		[[nodiscard]] void* allocate()
+		{
+			if (m_ThreadCached && !t_CacheDestroyed)
+			{
+				ThreadCache& cache = t_Cache;
+				if (!cache.head) [[unlikely]]
+					refill(cache);
+
+				if (Slot* slot = cache.head) [[likely]]
+				{
+					cache.head = slot->next;
+					--cache.count;
+					return slot;
+				}
+
+				return nullptr;
+			}
+
+			std::lock_guard lock(m_Mutex);
+			return allocate_locked();
+		}
+
+		/** Gives storage returned by allocate() back to the pool. */
+		void deallocate(void* memory)
+		{
+			Slot* slot = static_cast<Slot*>(memory);
+			if (m_ThreadCached && !t_CacheDestroyed)
+			{
+				ThreadCache& cache = t_Cache;
+				slot->next = cache.head;
+				cache.head = slot;
+				if (++cache.count > THREAD_CACHE_SIZE) [[unlikely]]
+					flush(cache, THREAD_CACHE_SIZE / 2);
+
+				return;
+			}
+
+			std::lock_guard lock(m_Mutex);
+			slot->next = m_FreeList;
+			m_FreeList = slot;
+		}
+
+		usize get_objects_per_slab() const { return m_ObjectsPerSlab; }
+
+		usize get_num_slabs() const
+		{
+			std::lock_guard lock(m_Mutex);
+			return m_NumSlabs;
+		}
+
+	private:
+		union Slot
+		{
+			Slot* next;
+			alignas(T) std::byte storage[sizeof(T)];
+		};
+
+		struct Slab
+		{
+			Slab* next{};
+		};
+
+		// Free slots of the pool returned by get(), handed back to the pool when the thread exits.
+		// Objects freed by thread-local destructors that run after it go straight to the pool.
+		struct ThreadCache
+		{
+			~ThreadCache()
+			{
+				if (head)
+					get().flush(*this, count);
+
+				t_CacheDestroyed = true;
+			}
+
+			Slot* head{};
+			u32	  count{};
+		};
+
+		ObjectPool(const usize slab_size, const bool thread_cached)
+			: m_ObjectsPerSlab(std::max<usize>((slab_size - get_slots_offset()) / sizeof(Slot), 1))
+			, m_ThreadCached(thread_cached)
+		{
+		}
+
+		static constexpr usize get_slots_offset() { return Math::align_up(sizeof(Slab), alignof(Slot)); }
+
+		// Expects the lock to be held.
+		Slot* allocate_locked()
+		{
+			if (Slot* slot = m_FreeList)
+			{
+				m_FreeList = slot->next;
+				return slot;
+			}
+
+			// Slots of the newest slab are handed out in order, so a new slab isn't written to before it's used
+			if (m_SlabCursor == m_SlabEnd)
+			{
+				const usize slab_size = get_slots_offset() + m_ObjectsPerSlab * sizeof(Slot);
+				Slab*		slab = static_cast<Slab*>(alignof(Slot) > alignof(std::max_align_t) ? allocate_memory_aligned(slab_size, alignof(Slot)) : allocate_memory(slab_size));
+				if (!slab)
+					return nullptr;
+
+				std::construct_at(slab);
+				slab->next = m_Slabs;
+				m_Slabs = slab;
+				++m_NumSlabs;
+
+				m_SlabCursor = reinterpret_cast<Slot*>(reinterpret_cast<std::byte*>(slab) + get_slots_offset());
+				m_SlabEnd = m_SlabCursor + m_ObjectsPerSlab;
+			}
+
+			return m_SlabCursor++;
+		}
+
+		void refill(ThreadCache& cache)
+		{
+			std::lock_guard lock(m_Mutex);
+			while (cache.count < THREAD_CACHE_SIZE / 2)
+			{
+				Slot* slot = allocate_locked();
+				if (!slot)
+					break;
+
+				slot->next = cache.head;
+				cache.head = slot;
+				++cache.count;
+			}
+		}
+
+		void flush(ThreadCache& cache, const u32 count)
+		{
+			// Unlink the chain outside of the lock, then splice it in at once
+			Slot* first = cache.head;
+			Slot* last = first;
+			for (u32 index = 1; index < count; ++index)
+			{
+				last = last->next;
+			}
+
+			cache.head = last->next;
+			cache.count -= count;
+
+			std::lock_guard lock(m_Mutex);
+			last->next = m_FreeList;
+			m_FreeList = first;
+		}
+
+		mutable std::mutex m_Mutex{};
+		Slot*			   m_FreeList{};
+		Slab*			   m_Slabs{};
+		Slot*			   m_SlabCursor{};
+		Slot*			   m_SlabEnd{};
+		usize			   m_NumSlabs{};
+		const usize		   m_ObjectsPerSlab{};
+		const bool		   m_ThreadCached{};
+
+		static inline thread_local ThreadCache t_Cache{};
+		// Kept outside of the cache, so it can still be read once the cache is destroyed
+		static inline thread_local bool t_CacheDestroyed{};
+	};
+} // namespace aw::core
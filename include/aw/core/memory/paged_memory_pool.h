@@ -2,10 +2,18 @@
 
 #include "aw/core/primitive/numbers.h"
 #include "aw/core/math/math.h"
+#include "aw/core/memory/size_classes.h"
+#include "aw/core/memory/buddy_allocator.h"
+#include "aw/core/memory/numa.h"
+#include "aw/core/memory/pool_stats.h"
+#include "aw/core/memory/memory_tags.h"
 
 #include <array>
 #include <shared_mutex>
 #include <atomic>
+#include <limits>
+#include <mutex>
+#include <new>
 
 namespace aw::core
 {
@@ -69,98 +77,588 @@ namespace aw::core
 		u64 value{};
 	};
 
-	struct AllocationHeader
+#ifdef AW_HEADERLESS_ALLOCATIONS
+	inline constexpr bool HEADERLESS_ALLOCATIONS = true;
+#else
+	inline constexpr bool HEADERLESS_ALLOCATIONS = false;
+#endif
+
+	/**
+	 * Sits in front of every paged block to remember the requested size.
+	 * With AW_HEADERLESS_ALLOCATIONS the header is dropped and the size of the block is reported instead.
+	 */
+	struct alignas(16) AllocationHeader
 	{
-		class MemoryPage* page{};
-		u32				  index{};
-		u32				  alloc_size{};
+		u32 alloc_size{};
 	};
 
+	inline constexpr u64 ALLOCATION_HEADER_SIZE = HEADERLESS_ALLOCATIONS ? 0 : sizeof(AllocationHeader);
+
+	/**
+	 * Lock-free stack of free block indices (Treiber stack).
+	 * The index of the next free block is stored in the free block itself, so the list never allocates.
+	 * The head is tagged with a counter that changes on every update, so a pop can't succeed on a stale head (ABA).
+	 */
 	struct PageFreeList
 	{
-		static constexpr u64	DEFAULT_PREALLOCATED_CAPACITY = 1024;
-		static constexpr double CAPACITY_INCREMENT = 1.5;
-
-		PageFreeList(u32 preallocated_capacity = DEFAULT_PREALLOCATED_CAPACITY);
+		static constexpr u32 INVALID_INDEX = std::numeric_limits<u32>::max();
 
-		~PageFreeList();
+		PageFreeList(u8* blocks, u64 block_stride);
 
 		void push(u32 index);
 
+		/** Links 'index' to 'next'. Used to build a chain of blocks before pushing it with push_chain(). */
+		void link(u32 index, u32 next);
+
+		/** Pushes a chain of blocks, linked from 'first' to 'last', with a single CAS. */
+		void push_chain(u32 first, u32 last);
+
 		u32 peek() const;
 
 		u32 pop();
 
-		std::atomic<u32*> data{};
-		std::atomic<u32>  tail{};
-		std::atomic<u32>  capacity{};
-		std::atomic<u32>  size{};
-		std::mutex		  m_Mutex{};
+		/** Takes the whole list with a single exchange and returns its first block. The others are reached with get_next(). */
+		u32 take_all();
+
+		/** Returns the block linked after 'index', which must have been taken off the list. */
+		u32 get_next(const u32 index) const { return get_link(index).load(std::memory_order::relaxed); }
+
+		bool is_empty() const { return peek() == INVALID_INDEX; }
+
+		/** Drops all blocks from the list. Must not run concurrently with other operations. */
+		void clear();
+
+	private:
+		static constexpr u64 make_head(const u64 tag, const u32 index) { return (tag << 32) | index; }
+		static constexpr u32 get_head_index(const u64 head) { return static_cast<u32>(head); }
+		static constexpr u64 get_head_tag(const u64 head) { return head >> 32; }
+
+		std::atomic_ref<u32> get_link(u32 index) const;
+
+		u8*				 m_Blocks{};
+		u64				 m_BlockStride{};
+		std::atomic<u64> m_Head{ make_head(0, INVALID_INDEX) };
 	};
 
 	static constexpr Bytes DEFAULT_PAGE_SIZE = Megabytes(4);
 
+	class PageTree;
+	class PagedMemoryPool;
+
+	/**
+	 * A DEFAULT_PAGE_SIZE-aligned chunk of memory, which starts with this object and is followed by the blocks.
+	 * The page of any allocation is found by masking its address, so the blocks don't have to point back to it.
+	 * Allocations too big for a page get a chunk of their own, which has no page tree. Chunks of up to 64 MB are blocks of the BuddyAllocator.
+	 *
+	 * The chunk is reserved address space. Only its beginning is committed up front, the rest is committed as the tail advances.
+	 */
 	class MemoryPage
 	{
 	public:
-		MemoryPage(const Bytes aligned_alloc_size)
-			: m_AlignedAllocSize(aligned_alloc_size)
-			, m_MaxAllocations(DEFAULT_PAGE_SIZE / aligned_alloc_size)
+		static constexpr Bytes COMMIT_STEP = Kilobytes(64);
+		static constexpr Bytes HUGE_PAGE_COMMIT_STEP = Megabytes(2);
+
+		MemoryPage(PageTree* tree, const Bytes aligned_alloc_size, const Bytes committed_size, const Bytes commit_step = COMMIT_STEP)
+			: m_FreeList(get_blocks(), aligned_alloc_size)
+			, m_Tree(tree)
+			, m_AlignedAllocSize(aligned_alloc_size)
+			, m_MaxAllocations((DEFAULT_PAGE_SIZE - get_blocks_offset()) / aligned_alloc_size)
+			, m_IndexMultiplier(((1ull << 32) + aligned_alloc_size - 1) / aligned_alloc_size)
+			, m_CommittedSize(committed_size)
+			, m_CommitStep(commit_step)
 		{
 		}
 
-		void set_root() { m_Root = true; }
+		/** Offset of the first block from the start of the page. */
+		static constexpr u64 get_blocks_offset() { return Math::align_up(sizeof(MemoryPage), 64); }
 
-		void* allocate_block(u64 requested_size);
+		static MemoryPage* from_allocation(const void* memory)
+		{
+			return reinterpret_cast<MemoryPage*>(reinterpret_cast<std::uintptr_t>(memory) & ~(DEFAULT_PAGE_SIZE - 1));
+		}
+
+		Bytes get_block_size() const { return m_AlignedAllocSize; }
+
+		u64 get_max_allocations() const { return m_MaxAllocations; }
+
+		/** Number of bytes from the start of the page that are backed by physical memory. */
+		Bytes get_committed_size() const { return m_CommittedSize; }
+
+		/** Size of the reservation the page sits in. */
+		Bytes get_chunk_size() const
+		{
+			if (is_buddy_block())
+				return m_BuddyBlockSize;
+
+			return is_large_allocation() ? Math::align_up(get_blocks_offset() + m_AlignedAllocSize, DEFAULT_PAGE_SIZE) : DEFAULT_PAGE_SIZE.value;
+		}
+
+		PageTree* get_tree() const { return m_Tree; }
+
+		/** Heap the blocks of the page or the large allocation belong to. */
+		PagedMemoryPool* get_heap() const;
+
+		bool is_large_allocation() const { return m_Tree == nullptr; }
+
+		bool is_buddy_block() const { return m_BuddyBlockSize != 0; }
+
+		u64 get_num_alive_allocations() const { return m_UsageState.load(std::memory_order::relaxed) & ALIVE_ALLOCATIONS_MASK; }
 
 		static void free_block(void* block);
 
-		void shutdown();
+		/** Returns the blocks to their pages without locking. Consecutive blocks of the same page are pushed to its free list at once. */
+		static void free_blocks(void* const* blocks, u32 count);
+
+		/**
+		 * Takes up to 'count' free blocks for the thread cache that owns the page, without the lock of the tree.
+		 * Blocks freed by other threads are taken off the free list all at once, the ones that don't fit are kept in 'chain' for the next call.
+		 */
+		u32 reclaim_blocks(u32& chain, void** out_blocks, u32 count);
+
+		/** Gives up the ownership taken with PageTree::allocate_blocks() and returns the blocks left in 'chain' to the free list. */
+		void release_ownership(u32 chain);
 
 	private:
-		void alloc_next();
+		friend class PageTree;
+		friend class PagedMemoryPool;
+		friend class BuddyAllocator;
+
+		static constexpr u64 ALIVE_ALLOCATIONS_MASK = 0xFFFFFFFF;
+		static constexpr u64 PENDING_RELEASE_CHECK = 1ull << 32;
+
+		// Allocates up to 'count' blocks from this page only. Expects the lock of the page tree to be held.
+		u32 allocate_blocks(u64 requested_size, void** out_blocks, u32 count);
+
+		// Pushes a chain of free blocks and moves the page out of the full list if it was in there.
+		void push_free_chain(u32 first, u32 last);
 
-		void dealloc_next();
+		// Drops 'count' live allocations, and releases the page if it became empty. The page must not be touched afterwards.
+		void drop_allocations(u64 count);
 
-		void* initialize_header(u64 index, u64 requested_size);
+		bool is_exhausted() const { return m_Tail == m_MaxAllocations && m_FreeList.is_empty(); }
 
-		void* get_block_at_index(u64 index);
+		// Makes sure the first 'num_blocks' blocks are committed. Expects the lock of the page tree to be held.
+		bool commit_blocks(u64 num_blocks);
+
+		// Returns the memory of all blocks to the OS and starts allocating from the beginning again.
+		// The page must be empty. Returns the number of decommitted bytes.
+		u64 decommit_blocks();
+
+		void* initialize_block(u64 index, u64 requested_size);
+
+		u8* get_blocks() const { return const_cast<u8*>(reinterpret_cast<const u8*>(this)) + get_blocks_offset(); }
+
+		u8* get_block_at_index(u64 index) const;
+
+		// Returns the index of the block the address points into. Aligned allocations point into the middle of their block.
+		u32 get_block_index(const void* address) const
+		{
+			const u64 offset = static_cast<const u8*>(address) - get_blocks();
+
+			// The multiplier is rounded up, so the estimate is exact for the start of a block and at most one too high inside of it
+			const u64 index = (offset * m_IndexMultiplier) >> 32;
+			return static_cast<u32>(index * m_AlignedAllocSize > offset ? index - 1 : index);
+		}
 
 	private:
-		std::array<u8, DEFAULT_PAGE_SIZE> m_Memory{};
-		MemoryPage*						  m_Prev{};
-		MemoryPage*						  m_Next{};
-		PageFreeList					  m_FreeList{};
+		PageFreeList m_FreeList;
+		PageTree*	 m_Tree{};
+
+		// Heap of a large allocation. Pages know it through their tree.
+		PagedMemoryPool* m_Heap{};
+
+		// Links in the page tree list the page is currently in, or in the list of large allocations of the heap.
+		MemoryPage* m_Prev{};
+		MemoryPage* m_Next{};
 
 		// Aligned size of the allocation. This is the allocation step.
+		// For a large allocation, this is the distance from the first block to the end of the allocation.
 		Bytes m_AlignedAllocSize{};
 
-		const u64		 m_MaxAllocations{};
-		std::atomic<u64> m_NumAliveAllocations{ 0 };
+		const u64 m_MaxAllocations{};
+
+		// ceil(2^32 / block size)
+		const u64 m_IndexMultiplier{};
+
+		// Number of alive allocations in the low 32 bits. A thread cache that owns the page counts as one more, so the page isn't released under it.
+		// The high 32 bits count the frees that emptied the page and still have to check whether it can be released.
+		// The page is only released by the last of them, so the others never touch a released page.
+		std::atomic<u64> m_UsageState{ 0 };
+
+		// Whether the page is in the list of full pages of its tree.
+		std::atomic<bool> m_Full{};
+
+		// Number of live allocations in the page that are sampled by the HeapProfiler. Frees only look the sample up when it's non-zero.
+		std::atomic<u32> m_NumSamples{};
+
+		u64 m_Tail{};
+
+		Bytes m_CommittedSize{};
+		Bytes m_CommitStep{};
+
+		// Size of the block of the BuddyAllocator the chunk is, zero for pages and chunks of their own
+		Bytes m_BuddyBlockSize{};
+
+		// Whether the block sits in a free list of the BuddyAllocator
+		bool m_BuddyFree{};
+	};
+
+	/**
+	 * All pages of a single size class.
+	 * Pages with free blocks are kept in their own list, so an allocation goes straight to a usable page instead of walking the full ones.
+	 * Pages move on and off that list as they fill up and drain.
+	 * Pages that drained completely are retained for reuse, as long as the retention limits of the pool allow it.
+	 * Every NUMA node has trees of its own, whose pages are placed on the node.
+	 */
+	class PageTree
+	{
+	public:
+		PageTree(PagedMemoryPool* heap, const u64 size_class_index, const u32 node, const bool thread_cached)
+			: m_Heap(heap)
+			, m_BlockSize(SizeClasses::get_block_size(size_class_index))
+			, m_SizeClassIndex(size_class_index)
+			, m_Node(node)
+			, m_ThreadCached(thread_cached)
+		{
+		}
+
+		~PageTree();
 
-		u64		   m_Tail{};
-		bool	   m_Root{};
-		std::mutex m_Mutex{};
+		Bytes get_block_size() const { return m_BlockSize; }
+
+		u64 get_size_class_index() const { return m_SizeClassIndex; }
+
+		PagedMemoryPool* get_heap() const { return m_Heap; }
+
+		/** NUMA node the pages of the tree are placed on. */
+		u32 get_node() const { return m_Node; }
+
+		/** Whether the blocks go through the thread caches, which only serve the default heap. */
+		bool is_thread_cached() const { return m_ThreadCached; }
+
+		u64 get_num_pages() const { return m_NumPages.load(std::memory_order::relaxed); }
+
+		u64 get_blocks_per_page() const { return (DEFAULT_PAGE_SIZE - MemoryPage::get_blocks_offset()) / m_BlockSize; }
+
+		u64 get_num_empty_pages() const { return m_NumEmptyPages.load(std::memory_order::relaxed); }
+
+		u64 get_committed_bytes() const { return m_CommittedBytes.load(std::memory_order::relaxed); }
+
+		void* allocate_block(u64 requested_size);
+
+		/**
+		 * Allocates up to 'count' blocks, taking the tree lock only once.
+		 * Returns the number of blocks written to 'out_blocks'.
+		 * With 'owned_page', the page of the last block is handed to the caller, which reclaims the blocks freed to it without the lock
+		 * until it gives the page up with MemoryPage::release_ownership().
+		 */
+		u32 allocate_blocks(u64 requested_size, void** out_blocks, u32 count, MemoryPage** owned_page = nullptr);
+
+		/**
+		 * Creates pages until the tree can hand out 'num_blocks' blocks without going to the OS, and faults in the memory of those blocks.
+		 * Blocks of pages the tree already has count towards them. Returns the number of created pages.
+		 */
+		u64 reserve(u64 num_blocks);
+
+		u64 get_num_reclaimed_blocks() const { return m_NumReclaimedBlocks.load(std::memory_order::relaxed); }
+
+		/** Allocations and frees of the tree. Only counted for trees that aren't thread cached, the others count per thread. */
+		u64 get_num_allocations() const { return m_NumAllocations.load(std::memory_order::relaxed); }
+
+		u64 get_num_frees() const { return m_NumFrees.load(std::memory_order::relaxed); }
+
+	private:
+		friend class MemoryPage;
+		friend class PagedMemoryPool;
+
+		struct PageList
+		{
+			void push_front(MemoryPage* page);
+			void remove(MemoryPage* page);
+
+			MemoryPage* head{};
+		};
+
+		MemoryPage* create_page();
+
+		static void destroy_page(MemoryPage* page);
+
+		// Passes the pages created while the lock was held to the growth hook of the pool.
+		void report_new_pages(u64 num_pages) const;
+
+		// Called when a page in the full list got a block back.
+		void on_full_page_freed(MemoryPage* page);
+
+		// Called by every free that emptied the page.
+		void release_page_if_empty(MemoryPage* page);
+
+		// Decommits the retained empty pages. Returns the number of decommitted bytes.
+		u64 trim();
+
+		PageList		 m_AvailablePages{};
+		PageList		 m_FullPages{};
+		PageList		 m_EmptyPages{};
+		std::atomic<u64> m_NumPages{};
+		std::atomic<u64> m_NumEmptyPages{};
+		std::atomic<u64> m_CommittedBytes{};
+		std::atomic<u64> m_NumReclaimedBlocks{};
+		std::atomic<u64> m_NumAllocations{};
+		std::atomic<u64> m_NumFrees{};
+		PagedMemoryPool* m_Heap{};
+		Bytes			 m_BlockSize{};
+		u64				 m_SizeClassIndex{};
+		const u32		 m_Node{};
+		const bool		 m_ThreadCached{};
+		std::mutex		 m_Mutex{};
 	};
 
+	/**
+	 * A heap: page trees of all size classes plus the large allocations made through it.
+	 * get() returns the default heap, which is what allocate_memory() and aw_new use, and the only one served by the thread caches.
+	 * Other heaps are plain objects, e.g. to keep a subsystem from fragmenting the default heap, or to release all of its memory at once.
+	 *
+	 * Blocks find their heap through their page, so any block can be freed with free_memory(), no matter which heap it came from.
+	 * The tiers below the heaps are shared: the BuddyAllocator, the retention limits and the committed memory counters cover all heaps.
+	 */
 	class PagedMemoryPool
 	{
 	public:
+		/** Creates a heap of its own. Its allocations lock the page tree of their size class, as the thread caches only serve the default heap. */
+		PagedMemoryPool()
+			: PagedMemoryPool(false)
+		{
+		}
+
+		PagedMemoryPool(const PagedMemoryPool&) = delete;
+		PagedMemoryPool& operator=(const PagedMemoryPool&) = delete;
+
+		/** Returns the default heap. It is created on first use and never destroyed, so it can be used during static initialization and shutdown. */
 		static PagedMemoryPool& get();
 
+		/** Releases all pages and large allocations of the heap, including the blocks that weren't freed. */
 		~PagedMemoryPool();
 
+		static constexpr u64 MIN_ALIGNMENT = alignof(AllocationHeader);
+
+		// Bigger alignments are served from chunks of their own
+		static constexpr u64 MAX_PAGED_ALIGNMENT = Bytes(Kilobytes(4));
+
+		// The memory of a chunk has to start in its first DEFAULT_PAGE_SIZE bytes, so the chunk can be found by masking
+		static constexpr u64 MAX_ALIGNMENT = DEFAULT_PAGE_SIZE / 2;
+
 		void* allocate_memory(Bytes size);
 
+		/**
+		 * Allocates memory aligned to 'alignment', which must be a power of two no bigger than MAX_ALIGNMENT.
+		 * Up to MAX_PAGED_ALIGNMENT, the allocation is carved out of a bigger block of a page. The memory is freed with free_memory().
+		 */
+		void* allocate_memory_aligned(Bytes size, u64 alignment);
+
 		static void free_memory(void* memory);
 
+		/**
+		 * Frees memory returned by allocate_memory() or reallocate_memory() with 'size' as the size that was asked for.
+		 * The size class follows from the size instead of the page. Memory of allocate_memory_aligned() must be freed without the size.
+		 */
+		static void free_memory(void* memory, Bytes size);
+
+		/**
+		 * Resizes memory returned by allocate_memory() and keeps its contents, like realloc(). Moved memory stays in the heap it came from.
+		 * The memory stays in place while the new size belongs to the same size class, and large allocations grow into the rest of their chunk.
+		 * Chunks of their own that outgrow their reservation are moved by remapping their pages where the OS supports it.
+		 * Otherwise the contents are copied to a new allocation. Returns nullptr if that fails, the old memory stays valid then.
+		 */
+		void* reallocate_memory(void* memory, Bytes new_size);
+
 		static u64 get_allocation_size(const void* const data);
 
+		/**
+		 * Caps the bytes the live blocks and large allocations of the heap may take, e.g. for the heap of a memory tag.
+		 * An allocation that would go over the budget calls 'hook', and returns nullptr unless the hook lets it through.
+		 * Only heaps other than the default heap are tracked, the default heap counts its allocations per thread instead.
+		 */
+		void set_budget(Bytes max_live_bytes, PoolBudgetHook hook = nullptr);
+
+		Bytes get_budget() const { return m_Budget.load(std::memory_order::relaxed); }
+
+		/** Bytes taken by the live blocks (their block size) and large allocations of the heap. Always 0 for the default heap. */
+		Bytes get_live_bytes() const { return m_LiveBytes.load(std::memory_order::relaxed); }
+
+		Bytes get_peak_live_bytes() const { return m_PeakLiveBytes.load(std::memory_order::relaxed); }
+
+		/** Number of allocations that failed because they would have gone over the budget. */
+		u64 get_num_budget_failures() const { return m_NumBudgetFailures.load(std::memory_order::relaxed); }
+
+		/** Number of bytes that can be written to the allocation: up to the end of its block, or of its committed memory for large allocations. */
+		static u64 get_usable_size(const void* data);
+
+		/** Sets the number of blocks each thread keeps cached per size class. 0 disables thread caches. */
+		static void set_thread_cache_depth(u32 depth);
+
+		static u32 get_thread_cache_depth();
+
+		/** Returns all blocks cached by the calling thread back to their pages. */
+		static void flush_thread_cache();
+
+		/** Asks the OS to back pages created from now on with transparent huge pages. Pages are then committed 2 MB at a time. */
+		static void set_huge_pages_enabled(bool enabled) { s_HugePagesEnabled.store(enabled, std::memory_order::relaxed); }
+
+		static bool are_huge_pages_enabled() { return s_HugePagesEnabled.load(std::memory_order::relaxed); }
+
+		/**
+		 * Gives every NUMA node page trees of its own, picked by the node the allocating thread runs on, and binds their pages to the node.
+		 * Enabled by default. Machines without NUMA have a single node, so it makes no difference there.
+		 * When disabled, all threads share the trees of the first node, and the pages end up wherever they are touched first.
+		 */
+		static void set_numa_aware(bool enabled) { s_NumaAware.store(enabled, std::memory_order::relaxed); }
+
+		static bool is_numa_aware() { return s_NumaAware.load(std::memory_order::relaxed); }
+
+		/**
+		 * Limits how many pages that became empty are kept for reuse instead of being released.
+		 * Without retention, a workload that oscillates around a page boundary creates and releases a page on every cycle.
+		 */
+		static void set_max_empty_pages_per_class(u32 num_pages) { s_MaxEmptyPagesPerClass.store(num_pages, std::memory_order::relaxed); }
+
+		static u32 get_max_empty_pages_per_class() { return s_MaxEmptyPagesPerClass.load(std::memory_order::relaxed); }
+
+		/** Limits the committed memory kept in empty pages of all size classes together. */
+		static void set_max_retained_bytes(Bytes max_bytes) { s_MaxRetainedBytes.store(max_bytes, std::memory_order::relaxed); }
+
+		static Bytes get_max_retained_bytes() { return s_MaxRetainedBytes.load(std::memory_order::relaxed); }
+
+		/** Committed memory currently kept in empty pages. */
+		static Bytes get_retained_bytes() { return s_RetainedBytes.load(std::memory_order::relaxed); }
+
+		/**
+		 * Creates the pages for 'num_blocks' blocks of the size class up front and faults their memory in, so the first allocations
+		 * neither create pages nor wait for page faults. The pages belong to the NUMA node the calling thread runs on.
+		 * Pages that didn't get any blocks yet aren't released, so the reservation lasts until the blocks are used.
+		 * Returns the number of created pages, which is short of the request if the OS runs out of memory.
+		 */
+		u64 reserve(u64 size_class_index, u64 num_blocks);
+
+		/** Reserves blocks for 'bytes_per_class' bytes of allocations in every size class that is served from pages. */
+		u64 reserve(Bytes bytes_per_class);
+
+		/** Installs a hook that is called whenever any heap takes a page or a chunk of its own from the OS. nullptr removes it. */
+		static void set_growth_hook(PoolGrowthHook hook) { s_GrowthHook.store(hook, std::memory_order::release); }
+
+		static PoolGrowthHook get_growth_hook() { return s_GrowthHook.load(std::memory_order::acquire); }
+
+		/**
+		 * Takes a snapshot of the pool. The counters are read without stopping other threads, so the numbers are only roughly consistent with each other.
+		 * The size classes are those of this heap, while the committed memory, the large allocations and the buddy blocks are counted for all heaps.
+		 * Cheap enough to be called every few seconds to feed a metrics pipeline.
+		 */
+		PoolStats stats();
+
+		/**
+		 * Returns the memory of all retained empty pages and free blocks of the BuddyAllocator to the OS (madvise(MADV_DONTNEED) / MEM_DECOMMIT).
+		 * The pages stay reserved and are committed again when they get reused. Returns the number of released bytes.
+		 */
+		u64 trim();
+
+		static constexpr u64 get_size_class_index(const Bytes allocation_size)
+		{
+			return SizeClasses::get_index(allocation_size + ALLOCATION_HEADER_SIZE);
+		}
+
+		// The biggest class of which a page holds at least two blocks. Bigger blocks would leave the rest of their page unused,
+		// so they are allocated from the BuddyAllocator, which can hand the same memory out to allocations of any other size later.
+		static constexpr u64 MAX_PAGED_SIZE_CLASS_INDEX = SizeClasses::get_index((DEFAULT_PAGE_SIZE - MemoryPage::get_blocks_offset()) / 2 + 1) - 1;
+
+		static constexpr bool is_paged_allocation_size(const Bytes allocation_size)
+		{
+			return allocation_size + ALLOCATION_HEADER_SIZE <= SizeClasses::get_block_size(MAX_PAGED_SIZE_CLASS_INDEX);
+		}
+
+		/** Returns the page tree of the size class for the NUMA node the calling thread runs on. */
+		PageTree* get_page_tree(u64 size_class_index);
+
+		PageTree* get_page_tree(u64 size_class_index, u32 node);
+
 	private:
-		MemoryPage* get_page_tree_for_allocation(Bytes allocation_size);
+		friend class MemoryPage;
+		friend class PageTree;
+		friend class BuddyAllocator;
+
+		static void on_committed(u64 size);
+
+		static void on_decommitted(u64 size);
+
+		static void report_growth(const PoolGrowthEvent& event)
+		{
+			if (const PoolGrowthHook hook = get_growth_hook()) [[unlikely]]
+				hook(event);
+		}
+
+		explicit PagedMemoryPool(bool thread_cached)
+			: m_ThreadCached(thread_cached)
+		{
+		}
+
+		// Chunks of up to BuddyAllocator::MAX_BLOCK_SIZE come from the buddy allocator, bigger ones straight from the OS
+		void* allocate_large(Bytes size, u64 alignment = MIN_ALIGNMENT);
+
+		static MemoryPage* allocate_chunk(u64 used_size);
+
+		// Moves a chunk of its own to a reservation for 'used_size', without copying it where the OS supports it. Returns nullptr if it can't be moved.
+		static MemoryPage* remap_chunk(MemoryPage* page, u64 used_size);
+
+		// Resizes a large allocation without copying it. Returns nullptr if it has to be copied.
+		static void* resize_large(MemoryPage* page, void* memory, Bytes new_size);
+
+		// Makes the chunk of a large allocation fit 'used_size' bytes, moving it if its reservation has to change. Returns nullptr on failure.
+		static MemoryPage* resize_chunk(MemoryPage* page, u64 used_size);
+
+		// Counts the bytes against the budget. Returns false if the allocation has to fail. Heaps with thread caches aren't tracked.
+		bool charge(const u64 bytes) { return m_ThreadCached || charge_tracked(bytes); }
+
+		void uncharge(const u64 bytes)
+		{
+			if (!m_ThreadCached)
+				m_LiveBytes.fetch_sub(bytes, std::memory_order::relaxed);
+		}
 
-		std::array<MemoryPage*, 64> m_PageTrees{};
-		std::shared_mutex			m_PageTreesMutex{};
+		bool charge_tracked(u64 bytes);
+
+		static void free_paged(void* memory, MemoryPage* page, u64 size_class_index);
+
+		static void free_large(MemoryPage* page);
+
+		std::array<std::array<PageTree*, SizeClasses::NUM_CLASSES>, Numa::MAX_NODES> m_PageTrees{};
+		std::shared_mutex															 m_PageTreesMutex{};
+
+		// Large allocations of the heap, linked through their pages, so the heap can release them
+		MemoryPage* m_LargeAllocations{};
+		std::mutex	m_LargeAllocationsMutex{};
+
+		const bool m_ThreadCached{};
+
+		std::atomic<u64>			m_LiveBytes{};
+		std::atomic<u64>			m_PeakLiveBytes{};
+		std::atomic<u64>			m_Budget{ std::numeric_limits<u64>::max() };
+		std::atomic<PoolBudgetHook> m_BudgetHook{};
+		std::atomic<u64>			m_NumBudgetFailures{};
+
+		static inline std::atomic<bool> s_HugePagesEnabled{};
+		static inline std::atomic<bool> s_NumaAware{ true };
+		static inline std::atomic<u32>	s_MaxEmptyPagesPerClass{ 1 };
+		static inline std::atomic<u64>	s_MaxRetainedBytes{ Bytes(Megabytes(64)) };
+		static inline std::atomic<u64>	s_RetainedBytes{};
+
+		static inline std::atomic<PoolGrowthHook> s_GrowthHook{};
+
+		static inline std::atomic<u64> s_CommittedBytes{};
+		static inline std::atomic<u64> s_PeakCommittedBytes{};
+		static inline std::atomic<u64> s_LiveLargeAllocations{};
+		static inline std::atomic<u64> s_TotalLargeAllocations{};
+		static inline std::atomic<u64> s_LargeAllocationBytes{};
+		static inline std::atomic<u64> s_PeakLargeAllocationBytes{};
+
+		// Constant-initialized, so chunks can be allocated during static initialization
+		static inline BuddyAllocator s_BuddyAllocator{};
 	};
 } // namespace aw::core
 
@@ -170,9 +668,13 @@ inline constexpr bool CLEAR_EMPTY_PAGES = false;
 inline constexpr bool CLEAR_EMPTY_PAGES = true;
 #endif
 
+// The heap returns nullptr when it runs out of memory or budget, which a throwing allocation function must not
 inline void* operator new(const std::size_t size, aw::core::PagedMemoryPool& pool)
 {
-	return pool.allocate_memory(aw::core::Bytes(size));
+	if (void* memory = pool.allocate_memory(aw::core::Bytes(size)))
+		return memory;
+
+	throw std::bad_alloc();
 }
 
 inline void operator delete(void* ptr, aw::core::PagedMemoryPool& pool)
@@ -180,7 +682,22 @@ inline void operator delete(void* ptr, aw::core::PagedMemoryPool& pool)
 	pool.free_memory(ptr);
 }
 
+inline void* operator new(const std::size_t size, const std::align_val_t alignment, aw::core::PagedMemoryPool& pool)
+{
+	if (void* memory = pool.allocate_memory_aligned(aw::core::Bytes(size), static_cast<aw::core::u64>(alignment)))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+inline void operator delete(void* ptr, std::align_val_t, aw::core::PagedMemoryPool& pool)
+{
+	pool.free_memory(ptr);
+}
+
 #define aw_new new (aw::core::PagedMemoryPool::get())
+#define aw_new_in(heap) new (heap)
+#define aw_new_tagged(Tag) new (aw::core::MemoryTags::get_heap<Tag>())
 #define aw_delete(val)    \
 	std::destroy_at(val); \
 	aw::core::PagedMemoryPool::get().free_memory(val)
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+#include "aw/core/memory/size_classes.h"
+#include "aw/core/memory/buddy_allocator.h"
+
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace aw::core
+{
+	class PagedMemoryPool;
+
+	/** A heap took memory from the OS. See PagedMemoryPool::set_growth_hook(). */
+	struct PoolGrowthEvent
+	{
+		enum class Kind : u8
+		{
+			// A page tree created a page
+			Page,
+			// A large allocation got a chunk of its own, too big for the BuddyAllocator
+			LargeChunk,
+		};
+
+		Kind				   kind{};
+		const PagedMemoryPool* heap{};
+
+		// Size class and NUMA node of the page tree, for pages
+		u64 size_class_index{};
+		u32 node{};
+
+		// Reserved address space of the page or chunk
+		u64 size{};
+	};
+
+	/** Called on the thread that made the heap grow. No lock of the pool is held, so the hook may allocate. */
+	using PoolGrowthHook = void (*)(const PoolGrowthEvent& event);
+
+	/**
+	 * Called when an allocation would take the live bytes of a heap over its budget, with the size the allocation takes from the heap.
+	 * Returning true lets the allocation through anyway, false makes it fail. Must not allocate from the heap itself.
+	 */
+	using PoolBudgetHook = bool (*)(PagedMemoryPool& heap, u64 requested_bytes);
+
+	struct SizeClassStats
+	{
+		u64 block_size{};
+		u64 num_pages{};
+		u64 num_empty_pages{};
+
+		// Blocks allocated and not freed yet. Blocks sitting in thread caches don't count.
+		u64 live_blocks{};
+		u64 total_allocations{};
+
+		u64 committed_bytes{};
+		u64 used_bytes{};
+
+		// Blocks thread caches took back from the free lists of the pages they own, without locking the page tree
+		u64 reclaimed_blocks{};
+	};
+
+	/** Snapshot of the state of the PagedMemoryPool. See PagedMemoryPool::stats(). */
+	struct PoolStats
+	{
+		std::array<SizeClassStats, SizeClasses::NUM_CLASSES> size_classes{};
+
+		// Memory backed by physical pages, for pages, large allocations and free blocks of the BuddyAllocator together
+		u64 committed_bytes{};
+		u64 peak_committed_bytes{};
+
+		// Block size of the live blocks plus the size of the live large allocations
+		u64 used_bytes{};
+
+		// Committed memory of empty pages kept for reuse
+		u64 retained_bytes{};
+
+		u64 live_large_allocations{};
+		u64 total_large_allocations{};
+		u64 large_allocation_bytes{};
+		u64 peak_large_allocation_bytes{};
+
+		// The part of the large allocations served by the BuddyAllocator
+		BuddyStats buddy{};
+
+		/** Human-readable summary with a row for every size class that has pages. */
+		std::string to_string() const;
+
+		/** The same data as a JSON object, for exporting it to a metrics pipeline. */
+		std::string to_json() const;
+	};
+
+	/**
+	 * Allocation counters of a single thread.
+	 * Only the owning thread writes its counters, so they are bumped with a relaxed load and store instead of a read-modify-write,
+	 * and threads never contend on them. PagedMemoryPool::stats() adds up the counters of all threads.
+	 */
+	class ThreadAllocationCounters
+	{
+	public:
+		static void record_allocation(const u64 size_class_index)
+		{
+			if (ThreadAllocationCounters* counters = get()) [[likely]]
+				increment(counters->m_Allocations[size_class_index]);
+			else
+				s_ExitedThreadAllocations[size_class_index].fetch_add(1, std::memory_order::relaxed);
+		}
+
+		static void record_free(const u64 size_class_index)
+		{
+			if (ThreadAllocationCounters* counters = get()) [[likely]]
+				increment(counters->m_Frees[size_class_index]);
+			else
+				s_ExitedThreadFrees[size_class_index].fetch_add(1, std::memory_order::relaxed);
+		}
+
+		/** Adds the counters of all threads, including the ones that exited already, to the size classes of 'stats'. */
+		static void collect(PoolStats& stats);
+
+	private:
+		friend struct ThreadAllocationCountersOwner;
+
+		// Returns nullptr once the thread is exiting.
+		static ThreadAllocationCounters* get() { return t_Counters ? t_Counters : create(); }
+
+		static ThreadAllocationCounters* create();
+
+		static void increment(std::atomic<u64>& counter) { counter.store(counter.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed); }
+
+		std::array<std::atomic<u64>, SizeClasses::NUM_CLASSES> m_Allocations{};
+		std::array<std::atomic<u64>, SizeClasses::NUM_CLASSES> m_Frees{};
+
+		// Links in the list of all living threads.
+		ThreadAllocationCounters* m_Prev{};
+		ThreadAllocationCounters* m_Next{};
+
+		static inline thread_local ThreadAllocationCounters* t_Counters{};
+
+		// Counters of exited threads, and of frees that happen while a thread is exiting.
+		static inline std::array<std::atomic<u64>, SizeClasses::NUM_CLASSES> s_ExitedThreadAllocations{};
+		static inline std::array<std::atomic<u64>, SizeClasses::NUM_CLASSES> s_ExitedThreadFrees{};
+	};
+} // namespace aw::core
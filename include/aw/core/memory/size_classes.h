@@ -0,0 +1,71 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+#include "aw/core/math/math.h"
+
+#include <algorithm>
+#include <array>
+
+namespace aw::core
+{
+	/**
+	 * Block sizes the PagedMemoryPool serves (jemalloc-style).
+	 * Small blocks step by 16 bytes up to 128 bytes, then every doubling is split into 4 classes,
+	 * so a block wastes at most 20% of its size instead of up to 50% with power-of-two classes.
+	 */
+	struct SizeClasses
+	{
+		static constexpr u64 SMALL_STEP = 16;
+		static constexpr u64 SMALL_LIMIT_LOG2 = 7;
+		static constexpr u64 SMALL_LIMIT = 1ull << SMALL_LIMIT_LOG2;
+		static constexpr u64 NUM_SMALL_CLASSES = SMALL_LIMIT / SMALL_STEP;
+
+		static constexpr u64 CLASSES_PER_DOUBLING_LOG2 = 2;
+		static constexpr u64 CLASSES_PER_DOUBLING = 1ull << CLASSES_PER_DOUBLING_LOG2;
+
+		// Biggest block is 4 MB, which is the size of the memory page.
+		static constexpr u64 MAX_BLOCK_SIZE_LOG2 = 22;
+		static constexpr u64 MAX_BLOCK_SIZE = 1ull << MAX_BLOCK_SIZE_LOG2;
+
+		static constexpr u64 NUM_CLASSES = NUM_SMALL_CLASSES + (MAX_BLOCK_SIZE_LOG2 - SMALL_LIMIT_LOG2) * CLASSES_PER_DOUBLING;
+
+		static constexpr std::array<u32, NUM_CLASSES> BLOCK_SIZES = [] {
+			std::array<u32, NUM_CLASSES> sizes{};
+			for (u64 index = 0; index < NUM_SMALL_CLASSES; ++index)
+			{
+				sizes[index] = to_u32((index + 1) * SMALL_STEP);
+			}
+
+			for (u64 index = NUM_SMALL_CLASSES; index < NUM_CLASSES; ++index)
+			{
+				const u64 doubling = SMALL_LIMIT_LOG2 + (index - NUM_SMALL_CLASSES) / CLASSES_PER_DOUBLING;
+				const u64 step = (index - NUM_SMALL_CLASSES) % CLASSES_PER_DOUBLING + 1;
+				sizes[index] = to_u32((1ull << doubling) + step * (1ull << (doubling - CLASSES_PER_DOUBLING_LOG2)));
+			}
+			return sizes;
+		}();
+
+		/** Returns the index of the smallest class that fits the block. The block must not be bigger than MAX_BLOCK_SIZE. */
+		static constexpr u64 get_index(const u64 block_size)
+		{
+			const u64 size = std::max<u64>(block_size, 1) - 1;
+
+			// Both indices are computed and one of them is selected, so there is no branch to mispredict.
+			const u64 small_index = size / SMALL_STEP;
+
+			const u64 doubling = std::max(Math::fast_log2(size | 1), SMALL_LIMIT_LOG2);
+			const u64 step = (size >> (doubling - CLASSES_PER_DOUBLING_LOG2)) & (CLASSES_PER_DOUBLING - 1);
+			const u64 large_index = NUM_SMALL_CLASSES + (doubling - SMALL_LIMIT_LOG2) * CLASSES_PER_DOUBLING + step;
+
+			return size < SMALL_LIMIT ? small_index : large_index;
+		}
+
+		static constexpr u64 get_block_size(const u64 index)
+		{
+			return BLOCK_SIZES[index];
+		}
+	};
+
+	static_assert(SizeClasses::BLOCK_SIZES.back() == SizeClasses::MAX_BLOCK_SIZE);
+	static_assert(SizeClasses::get_index(SizeClasses::MAX_BLOCK_SIZE) == SizeClasses::NUM_CLASSES - 1);
+} // namespace aw::core
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "aw/core/memory/linear_arena.h"
+
+namespace aw::core
+{
+	class StackAllocator;
+
+	/** Pops the stack back to where it was when the scope was created. See StackAllocator::scope(). */
+	class StackAllocatorScope
+	{
+	public:
+		StackAllocatorScope(StackAllocator& stack) noexcept;
+
+		StackAllocatorScope(StackAllocatorScope&& other) noexcept
+			: m_Stack(other.m_Stack)
+			, m_Marker(other.m_Marker)
+			, m_Active(other.m_Active)
+		{
+			other.m_Active = false;
+		}
+
+		~StackAllocatorScope() noexcept;
+
+		StackAllocatorScope(const StackAllocatorScope&) = delete;
+
+		StackAllocatorScope& operator=(const StackAllocatorScope&) = delete;
+
+	private:
+		StackAllocator&		m_Stack;
+		LinearArena::Marker m_Marker;
+		bool				m_Active = true;
+	};
+
+	/**
+	 * Scratch memory that is freed in reverse order of allocation.
+	 * push() marks the top of the stack, and pop() frees everything allocated after the marker, so every nesting level
+	 * reuses the memory the previous one at the same depth gave back.
+	 * StackAllocator::get() returns a stack owned by the calling thread, so workers of a ThreadPool allocate scratch memory without locking.
+	 *
+	 * Containers allocate from the stack with an ArenaAllocator over get_arena().
+	 */
+	class StackAllocator
+	{
+	public:
+		using Marker = LinearArena::Marker;
+
+		explicit StackAllocator(const usize chunk_size = LinearArena::DEFAULT_CHUNK_SIZE)
+			: m_Arena(chunk_size)
+		{
+		}
+
+		/** Returns the stack of the calling thread. It's released when the thread exits. */
+		static StackAllocator& get();
+
+		[[nodiscard]] void* allocate(const usize size, const usize alignment = alignof(std::max_align_t))
+		{
+			return m_Arena.allocate(size, alignment);
+		}
+
+		template <typename T>
+		[[nodiscard]] T* allocate_array(const usize count)
+		{
+			if (count > std::numeric_limits<usize>::max() / sizeof(T))
+				return nullptr;
+
+			return static_cast<T*>(m_Arena.allocate(count * sizeof(T), alignof(T)));
+		}
+
+		[[nodiscard]] Marker push() const { return m_Arena.get_marker(); }
+
+		/** Frees everything allocated since push() returned the marker. Markers must be popped in reverse order. */
+		void pop(const Marker marker) { m_Arena.rewind(marker); }
+
+		/** Returns a guard that pops everything allocated during its lifetime. */
+		[[nodiscard]] StackAllocatorScope scope() { return StackAllocatorScope(*this); }
+
+		LinearArena& get_arena() { return m_Arena; }
+
+	private:
+		LinearArena m_Arena;
+	};
+
+	inline StackAllocatorScope::StackAllocatorScope(StackAllocator& stack) noexcept
+		: m_Stack(stack)
+		, m_Marker(stack.push())
+	{
+	}
+
+	inline StackAllocatorScope::~StackAllocatorScope() noexcept
+	{
+		if (m_Active)
+			m_Stack.pop(m_Marker);
+	}
+} // namespace aw::core
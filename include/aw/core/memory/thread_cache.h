@@ -0,0 +1,66 @@
+#pragma once
+
+#include "paged_memory_pool.h"
+
+#include <array>
+#include <atomic>
+
+namespace aw::core
+{
+	/**
+	 * Per-thread magazines of free blocks, one per small size class.
+	 * Blocks are moved between the magazines and the page trees in batches, so the common allocation and free path doesn't take any lock.
+	 * Every magazine owns the page of its last refill. Blocks other threads free to that page are reclaimed in bulk, without the lock of the tree,
+	 * before the magazine goes back to the tree for more.
+	 * The cache of a thread is flushed automatically when the thread exits.
+	 */
+	class ThreadCache
+	{
+	public:
+		static constexpr u32   DEFAULT_DEPTH = 64;
+		static constexpr u32   MAX_DEPTH = 1024;
+		static constexpr Bytes MAX_CACHED_BLOCK_SIZE = Kilobytes(32);
+		static constexpr u64   NUM_CACHED_CLASSES = SizeClasses::get_index(MAX_CACHED_BLOCK_SIZE) + 1;
+
+		/** Returns the cache of the calling thread. Returns nullptr if the caching is disabled or the thread is exiting. */
+		static ThreadCache* get();
+
+		static void set_depth(u32 depth);
+		static u32	get_depth() { return s_Depth.load(std::memory_order::relaxed); }
+
+		static bool is_class_cached(const u64 size_class_index) { return size_class_index < NUM_CACHED_CLASSES; }
+
+		~ThreadCache();
+
+		void* allocate(PagedMemoryPool& pool, u64 size_class_index, u64 requested_size);
+
+		void deallocate(void* block, u64 size_class_index);
+
+		/** Returns all cached blocks to their pages and gives up the owned pages. */
+		void flush();
+
+	private:
+		struct Magazine
+		{
+			void** blocks{};
+			u32	   count{};
+			u32	   capacity{};
+
+			// Page the magazine reclaims freed blocks from, and the blocks it took off its free list but didn't need yet
+			MemoryPage* owned_page{};
+			u32			reclaimed{ PageFreeList::INVALID_INDEX };
+		};
+
+		bool reserve_magazine(Magazine& magazine, u32 depth);
+
+		static u32 refill(Magazine& magazine, PageTree* page_tree, u64 requested_size, u32 count);
+
+		static void release_owned_page(Magazine& magazine);
+
+		static void flush_oldest(Magazine& magazine, u32 count);
+
+		std::array<Magazine, NUM_CACHED_CLASSES> m_Magazines{};
+
+		static inline std::atomic<u32> s_Depth{ DEFAULT_DEPTH };
+	};
+} // namespace aw::core
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "aw/core/primitive/numbers.h"
+
+namespace aw::core
+{
+	/**
+	 * Thin wrapper over the virtual memory API of the OS.
+	 * Address space is reserved first and only backed by physical memory once it's committed,
+	 * so big regions can be set aside up front without growing the RSS of the process.
+	 */
+	struct VirtualMemory
+	{
+		/** Returns the granularity of commit() and decommit(). */
+		static u64 get_page_size();
+
+		/** Reserves 'size' bytes of inaccessible address space at an address aligned to 'alignment' (a power of two). Returns nullptr on failure. */
+		static void* reserve(u64 size, u64 alignment);
+
+		/** Makes the pages in the range readable and writable. The range must be page-aligned and lie in a reservation. */
+		static bool commit(void* address, u64 size);
+
+		/** Backs a committed range with physical memory right away, instead of on the first access to each of its pages. Keeps the contents. */
+		static void prefault(void* address, u64 size);
+
+		/** Returns the physical memory of the range to the OS. The range stays reserved and has to be committed again before it's used. */
+		static void decommit(void* address, u64 size);
+
+		/**
+		 * Moves the committed pages of a range to 'new_address', which must lie in another reservation, without copying them (mremap).
+		 * The old range is left unmapped. Returns false where the OS can't move pages, the memory has to be copied then.
+		 */
+		static bool remap(void* address, u64 size, void* new_address);
+
+		/** Releases the whole reservation. 'size' must be the size passed to reserve(). */
+		static void release(void* address, u64 size);
+
+		/** Asks the OS to back the range with transparent huge pages. Does nothing where it isn't supported. */
+		static void advise_huge_pages(void* address, u64 size);
+	};
+} // namespace aw::core
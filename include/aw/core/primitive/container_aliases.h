@@ -1,6 +1,7 @@
 #pragma once
 
 #include "aw/core/memory/allocators.h"
+#include "aw/core/primitive/flat_hash_map.h"
 
 #include <vector>
 #include <unordered_map>
@@ -13,8 +14,23 @@ namespace aw::core
 	template <typename T, typename Allocator = DefaultAllocator<T>>
 	using Vector = std::vector<T, Allocator>;
 
+	/** Flat open addressing map. Inserting invalidates references to the elements, use NodeHashMap where they have to stay put. */
 	template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, typename Allocator = DefaultAllocator<std::pair<const Key, T>>>
-	using HashMap = std::unordered_map<Key, T, Hash, KeyEqual, Allocator>;
+	using HashMap = FlatHashMap<Key, T, Hash, KeyEqual, Allocator>;
+
+	template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, typename Allocator = DefaultAllocator<Key>>
+	using HashSet = FlatHashSet<Key, Hash, KeyEqual, Allocator>;
+
+	/** Map with a node per element, whose address doesn't change while it's in the map. */
+	template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, typename Allocator = DefaultAllocator<std::pair<const Key, T>>>
+	using NodeHashMap = std::unordered_map<Key, T, Hash, KeyEqual, Allocator>;
+
+	/** Containers whose memory belongs to a memory tag, see MemoryTags. */
+	template <typename T, MemoryTag Tag>
+	using TaggedVector = Vector<T, TaggedAllocator<T, Tag>>;
+
+	template <typename Key, typename T, MemoryTag Tag, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+	using TaggedHashMap = HashMap<Key, T, Hash, KeyEqual, TaggedAllocator<std::pair<const Key, T>, Tag>>;
 
 	template <typename T, typename Allocator = DefaultAllocator<T>>
 	using Queue = std::queue<T, std::deque<T, Allocator>>;
@@ -0,0 +1,961 @@
+#pragma once
+
+#include "aw/core/memory/allocators.h"
+#include "aw/core/primitive/relocatable_vector.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define AW_FLAT_HASH_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define AW_FLAT_HASH_SSE2 0
+#endif
+
+namespace aw::core
+{
+	/** Transparent hash of strings, so maps with std::string keys can be searched with a std::string_view or a literal. */
+	struct StringHash
+	{
+		using is_transparent = void;
+
+		usize operator()(const std::string_view value) const noexcept { return std::hash<std::string_view>{}(value); }
+	};
+
+	namespace detail
+	{
+		// Every slot has a control byte: empty, deleted, or the low 7 bits of the hash (H2) of the key in the slot
+		using ControlByte = i8;
+
+		inline constexpr ControlByte CONTROL_EMPTY = -128;
+		inline constexpr ControlByte CONTROL_DELETED = -2;
+
+		inline bool is_full(const ControlByte control) { return control >= 0; }
+
+		// Slots of a group that matched, one bit (or byte, without SSE2) per slot
+		template <u32 Shift>
+		class GroupMask
+		{
+		public:
+			explicit GroupMask(const u64 bits)
+				: m_Bits(bits)
+			{
+			}
+
+			explicit operator bool() const { return m_Bits != 0; }
+
+			u32 lowest() const { return static_cast<u32>(std::countr_zero(m_Bits)) >> Shift; }
+
+			void clear_lowest() { m_Bits &= m_Bits - 1; }
+
+		private:
+			u64 m_Bits;
+		};
+
+#if AW_FLAT_HASH_SSE2
+		// 16 control bytes compared at once
+		class Group
+		{
+		public:
+			static constexpr u32 WIDTH = 16;
+
+			explicit Group(const ControlByte* control)
+				: m_Control(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control)))
+			{
+			}
+
+			GroupMask<0> match(const u8 h2) const { return GroupMask<0>(mask_of(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), m_Control))); }
+
+			GroupMask<0> match_empty() const { return GroupMask<0>(mask_of(_mm_cmpeq_epi8(_mm_set1_epi8(CONTROL_EMPTY), m_Control))); }
+
+			// Empty and deleted are the control bytes with the sign bit set
+			GroupMask<0> match_free() const { return GroupMask<0>(mask_of(m_Control)); }
+
+		private:
+			static u64 mask_of(const __m128i bytes) { return static_cast<u16>(_mm_movemask_epi8(bytes)); }
+
+			__m128i m_Control;
+		};
+#else
+		// 8 control bytes compared at once in a 64-bit word, without SIMD instructions
+		class Group
+		{
+		public:
+			static constexpr u32 WIDTH = 8;
+
+			explicit Group(const ControlByte* control)
+			{
+				static_assert(std::endian::native == std::endian::little, "The slots are numbered from the low byte.");
+				std::memcpy(&m_Control, control, sizeof(m_Control));
+			}
+
+			// May report a slot after a real match as well, the key comparison sorts those out
+			GroupMask<3> match(const u8 h2) const
+			{
+				const u64 bytes = m_Control ^ (LSBS * h2);
+				return GroupMask<3>((bytes - LSBS) & ~bytes & MSBS);
+			}
+
+			GroupMask<3> match_empty() const { return GroupMask<3>(m_Control & ~(m_Control << 6) & MSBS); }
+
+			GroupMask<3> match_free() const { return GroupMask<3>(m_Control & ~(m_Control << 7) & MSBS); }
+
+		private:
+			static constexpr u64 LSBS = 0x0101010101010101;
+			static constexpr u64 MSBS = 0x8080808080808080;
+
+			u64 m_Control{};
+		};
+#endif
+
+		// Control bytes of tables without slots, so lookups don't need to check for them
+		inline constexpr std::array<ControlByte, Group::WIDTH> EMPTY_GROUP = [] {
+			std::array<ControlByte, Group::WIDTH> group{};
+			group.fill(CONTROL_EMPTY);
+			return group;
+		}();
+
+		// std::hash of integers is the identity, the multiplication spreads their bits over the whole word
+		inline u64 mix_hash(const u64 hash)
+		{
+			const u64 product = hash * 0x9e3779b97f4a7c15;
+			return product ^ (product >> 32);
+		}
+
+		inline u8 get_h2(const u64 hash) { return static_cast<u8>(hash >> 57); }
+
+		/**
+		 * Open addressing hash table in the layout of Swiss tables. The slots are split into groups whose control bytes are compared
+		 * with one SIMD instruction, so a lookup usually checks a single group, and the keys are only compared where the 7 bits of
+		 * the hash in the control byte match. The control bytes and the slots are one allocation from the allocator.
+		 */
+		template <typename Policy, typename Hash, typename KeyEqual, typename Allocator>
+		class FlatHashTable
+		{
+		public:
+			using key_type = typename Policy::key_type;
+			using value_type = typename Policy::value_type;
+			using size_type = usize;
+			using difference_type = std::ptrdiff_t;
+			using hasher = Hash;
+			using key_equal = KeyEqual;
+			using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+			using reference = value_type&;
+			using const_reference = const value_type&;
+
+		private:
+			using AllocatorTraits = std::allocator_traits<allocator_type>;
+
+			static constexpr bool IS_TRANSPARENT = requires {
+				typename Hash::is_transparent;
+				typename KeyEqual::is_transparent;
+			};
+
+			template <bool IsConst>
+			class Iterator
+			{
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = FlatHashTable::value_type;
+				using difference_type = std::ptrdiff_t;
+				using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+				using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+				Iterator() noexcept = default;
+
+				// A template, so it doesn't take the place of the copy constructor
+				template <bool OtherConst>
+					requires(IsConst && !OtherConst)
+				Iterator(const Iterator<OtherConst>& other) noexcept
+					: m_Control(other.m_Control)
+					, m_Slot(other.m_Slot)
+					, m_End(other.m_End)
+				{
+				}
+
+				reference operator*() const { return *m_Slot; }
+				pointer	  operator->() const { return m_Slot; }
+
+				Iterator& operator++()
+				{
+					++m_Control;
+					++m_Slot;
+					skip_free_slots();
+					return *this;
+				}
+
+				Iterator operator++(int)
+				{
+					Iterator old = *this;
+					++*this;
+					return old;
+				}
+
+				template <bool OtherConst>
+				bool operator==(const Iterator<OtherConst>& other) const
+				{
+					return m_Control == other.m_Control;
+				}
+
+			private:
+				friend class FlatHashTable;
+				template <bool>
+				friend class Iterator;
+
+				Iterator(const ControlByte* control, pointer slot, const ControlByte* end)
+					: m_Control(control)
+					, m_Slot(slot)
+					, m_End(end)
+				{
+				}
+
+				void skip_free_slots()
+				{
+					while (m_Control != m_End && !is_full(*m_Control))
+					{
+						++m_Control;
+						++m_Slot;
+					}
+				}
+
+				const ControlByte* m_Control{};
+				pointer			   m_Slot{};
+				const ControlByte* m_End{};
+			};
+
+		public:
+			// The elements of sets are their keys, which can't change while they're in the table
+			using iterator = Iterator<Policy::CONST_ELEMENTS>;
+			using const_iterator = Iterator<true>;
+
+			FlatHashTable() noexcept(std::is_nothrow_default_constructible_v<allocator_type>) = default;
+
+			explicit FlatHashTable(const allocator_type& allocator) noexcept
+				: m_Allocator(allocator)
+			{
+			}
+
+			explicit FlatHashTable(const usize capacity, const allocator_type& allocator = allocator_type())
+				: m_Allocator(allocator)
+			{
+				reserve(capacity);
+			}
+
+			template <std::input_iterator InputIt>
+			FlatHashTable(InputIt first, const InputIt last, const allocator_type& allocator = allocator_type())
+				: m_Allocator(allocator)
+			{
+				try
+				{
+					insert(first, last);
+				}
+				catch (...)
+				{
+					// The destructor doesn't run for a constructor that throws
+					destroy_storage();
+					throw;
+				}
+			}
+
+			FlatHashTable(const std::initializer_list<value_type> values, const allocator_type& allocator = allocator_type())
+				: FlatHashTable(values.begin(), values.end(), allocator)
+			{
+			}
+
+			FlatHashTable(const FlatHashTable& other)
+				: m_Hash(other.m_Hash)
+				, m_Equal(other.m_Equal)
+				, m_Allocator(AllocatorTraits::select_on_container_copy_construction(other.m_Allocator))
+			{
+				try
+				{
+					copy_elements(other);
+				}
+				catch (...)
+				{
+					destroy_storage();
+					throw;
+				}
+			}
+
+			FlatHashTable(FlatHashTable&& other) noexcept
+				: m_Control(std::exchange(other.m_Control, get_empty_group()))
+				, m_Slots(std::exchange(other.m_Slots, nullptr))
+				, m_Capacity(std::exchange(other.m_Capacity, 0))
+				, m_GroupMask(std::exchange(other.m_GroupMask, 0))
+				, m_Size(std::exchange(other.m_Size, 0))
+				, m_GrowthLeft(std::exchange(other.m_GrowthLeft, 0))
+				, m_Hash(std::move(other.m_Hash))
+				, m_Equal(std::move(other.m_Equal))
+				, m_Allocator(std::move(other.m_Allocator))
+			{
+			}
+
+			~FlatHashTable() { destroy_storage(); }
+
+			FlatHashTable& operator=(const FlatHashTable& other)
+			{
+				if (this != &other)
+				{
+					destroy_storage();
+					if constexpr (AllocatorTraits::propagate_on_container_copy_assignment::value)
+						m_Allocator = other.m_Allocator;
+
+					m_Hash = other.m_Hash;
+					m_Equal = other.m_Equal;
+					copy_elements(other);
+				}
+
+				return *this;
+			}
+
+			FlatHashTable& operator=(FlatHashTable&& other) noexcept(AllocatorTraits::propagate_on_container_move_assignment::value || AllocatorTraits::is_always_equal::value)
+			{
+				if (this == &other)
+					return *this;
+
+				if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value || AllocatorTraits::is_always_equal::value)
+				{
+					destroy_storage();
+					if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value)
+						m_Allocator = std::move(other.m_Allocator);
+
+					steal_storage(other);
+				}
+				else if (m_Allocator == other.m_Allocator)
+				{
+					destroy_storage();
+					steal_storage(other);
+				}
+				else
+				{
+					// The memory of the other table can't be freed by this allocator, so the elements move one by one
+					clear();
+					reserve(other.m_Size);
+					for (value_type& value : other)
+					{
+						insert(std::move(value));
+					}
+					other.clear();
+				}
+
+				m_Hash = std::move(other.m_Hash);
+				m_Equal = std::move(other.m_Equal);
+				return *this;
+			}
+
+			FlatHashTable& operator=(const std::initializer_list<value_type> values)
+			{
+				clear();
+				insert(values);
+				return *this;
+			}
+
+			void swap(FlatHashTable& other) noexcept
+			{
+				std::swap(m_Control, other.m_Control);
+				std::swap(m_Slots, other.m_Slots);
+				std::swap(m_Capacity, other.m_Capacity);
+				std::swap(m_GroupMask, other.m_GroupMask);
+				std::swap(m_Size, other.m_Size);
+				std::swap(m_GrowthLeft, other.m_GrowthLeft);
+				std::swap(m_Hash, other.m_Hash);
+				std::swap(m_Equal, other.m_Equal);
+				if constexpr (AllocatorTraits::propagate_on_container_swap::value)
+					std::swap(m_Allocator, other.m_Allocator);
+			}
+
+			friend void swap(FlatHashTable& first, FlatHashTable& second) noexcept { first.swap(second); }
+
+			iterator	   begin() noexcept { return make_iterator(0, true); }
+			iterator	   end() noexcept { return make_iterator(m_Capacity, false); }
+			const_iterator begin() const noexcept { return make_iterator(0, true); }
+			const_iterator end() const noexcept { return make_iterator(m_Capacity, false); }
+			const_iterator cbegin() const noexcept { return begin(); }
+			const_iterator cend() const noexcept { return end(); }
+
+			usize size() const noexcept { return m_Size; }
+			bool  empty() const noexcept { return m_Size == 0; }
+
+			/** Number of slots. The table grows once 7/8 of them are taken. */
+			usize capacity() const noexcept { return m_Capacity; }
+
+			allocator_type get_allocator() const noexcept { return m_Allocator; }
+			hasher		   hash_function() const { return m_Hash; }
+			key_equal	   key_eq() const { return m_Equal; }
+
+			/** Makes room for 'count' elements, so inserting them doesn't rehash the table. */
+			void reserve(const usize count)
+			{
+				// Empty tables don't allocate
+				if (count == 0)
+					return;
+
+				usize capacity = Group::WIDTH;
+				while (get_max_load(capacity) < count)
+				{
+					capacity *= 2;
+				}
+
+				if (capacity > m_Capacity)
+					resize(capacity);
+			}
+
+			/** Destroys the elements and keeps the memory. */
+			void clear() noexcept
+			{
+				if (m_Size == 0)
+				{
+					// No elements, but there may be deleted slots
+					if (m_Capacity != 0 && m_GrowthLeft != get_max_load(m_Capacity))
+					{
+						std::fill_n(m_Control, m_Capacity, CONTROL_EMPTY);
+						m_GrowthLeft = get_max_load(m_Capacity);
+					}
+
+					return;
+				}
+
+				destroy_elements();
+				std::fill_n(m_Control, m_Capacity, CONTROL_EMPTY);
+				m_Size = 0;
+				m_GrowthLeft = get_max_load(m_Capacity);
+			}
+
+			std::pair<iterator, bool> insert(const value_type& value) { return emplace_value(Policy::get_key(value), value); }
+			std::pair<iterator, bool> insert(value_type&& value) { return emplace_value(Policy::get_key(value), std::move(value)); }
+
+			template <std::input_iterator InputIt>
+			void insert(InputIt first, const InputIt last)
+			{
+				if constexpr (std::forward_iterator<InputIt>)
+					reserve(m_Size + static_cast<usize>(std::distance(first, last)));
+
+				for (; first != last; ++first)
+				{
+					insert(*first);
+				}
+			}
+
+			void insert(const std::initializer_list<value_type> values) { insert(values.begin(), values.end()); }
+
+			/** Constructs the element first, to find its key. Prefer insert() or try_emplace() when the key is at hand. */
+			template <typename... Args>
+			std::pair<iterator, bool> emplace(Args&&... args)
+			{
+				value_type value(std::forward<Args>(args)...);
+				return emplace_value(Policy::get_key(value), std::move(value));
+			}
+
+			iterator	   find(const key_type& key) { return make_iterator(find_index(key), false); }
+			const_iterator find(const key_type& key) const { return make_iterator(find_index(key), false); }
+
+			template <typename K>
+				requires IS_TRANSPARENT
+			iterator find(const K& key)
+			{
+				return make_iterator(find_index(key), false);
+			}
+
+			template <typename K>
+				requires IS_TRANSPARENT
+			const_iterator find(const K& key) const
+			{
+				return make_iterator(find_index(key), false);
+			}
+
+			bool contains(const key_type& key) const { return find_index(key) != m_Capacity; }
+
+			template <typename K>
+				requires IS_TRANSPARENT
+			bool contains(const K& key) const
+			{
+				return find_index(key) != m_Capacity;
+			}
+
+			usize count(const key_type& key) const { return contains(key) ? 1 : 0; }
+
+			template <typename K>
+				requires IS_TRANSPARENT
+			usize count(const K& key) const
+			{
+				return contains(key) ? 1 : 0;
+			}
+
+			/** Returns the number of erased elements, 0 or 1. */
+			usize erase(const key_type& key) { return erase_key(key); }
+
+			template <typename K>
+				requires IS_TRANSPARENT
+			usize erase(const K& key)
+			{
+				return erase_key(key);
+			}
+
+			/** Returns the iterator to the element after the erased one. Erasing doesn't move any other element. */
+			iterator erase(const const_iterator position)
+			{
+				const usize index = static_cast<usize>(position.m_Control - m_Control);
+				erase_index(index);
+				return make_iterator(index + 1, true);
+			}
+
+			iterator erase(const iterator position)
+				requires(!Policy::CONST_ELEMENTS)
+			{
+				return erase(const_iterator(position));
+			}
+
+		protected:
+			template <typename K>
+			usize find_index(const K& key) const
+			{
+				return find_index(key, hash_key(key));
+			}
+
+			// Returns the capacity if the key isn't in the table
+			template <typename K>
+			usize find_index(const K& key, const u64 hash) const
+			{
+				const u8 h2 = get_h2(hash);
+				for (ProbeSequence probe(hash, m_GroupMask);; probe.next())
+				{
+					const Group group(m_Control + probe.get_offset());
+					for (auto matches = group.match(h2); matches; matches.clear_lowest())
+					{
+						const usize index = probe.get_offset() + matches.lowest();
+						if (m_Equal(Policy::get_key(m_Slots[index]), key)) [[likely]]
+							return index;
+					}
+
+					// The key would have been put into the first group with a free slot
+					if (group.match_empty()) [[likely]]
+						return m_Capacity;
+				}
+			}
+
+			// Returns the slot of the key, and whether the key was new. The element of a new key has to be constructed by the caller.
+			template <typename K>
+			std::pair<usize, bool> find_or_prepare_insert(const K& key)
+			{
+				const u64 hash = hash_key(key);
+				if (const usize index = find_index(key, hash); index != m_Capacity)
+					return { index, false };
+
+				return { prepare_insert(hash), true };
+			}
+
+			// Undoes find_or_prepare_insert() for a new element whose constructor threw
+			void abandon_insert(const usize index) noexcept
+			{
+				m_Control[index] = CONTROL_DELETED;
+				--m_Size;
+			}
+
+			template <typename... Args>
+			void construct_at(const usize index, Args&&... args)
+			{
+				try
+				{
+					std::construct_at(m_Slots + index, std::forward<Args>(args)...);
+				}
+				catch (...)
+				{
+					abandon_insert(index);
+					throw;
+				}
+			}
+
+			iterator make_iterator(const usize index, const bool skip_free_slots) const
+			{
+				iterator iter(m_Control + index, m_Slots + index, m_Control + m_Capacity);
+				if (skip_free_slots)
+					iter.skip_free_slots();
+
+				return iter;
+			}
+
+			value_type& get_slot(const usize index) const { return m_Slots[index]; }
+
+		private:
+			// Triangular probing over the groups, which visits every group once when their number is a power of two
+			class ProbeSequence
+			{
+			public:
+				ProbeSequence(const u64 hash, const usize group_mask)
+					: m_Group(static_cast<usize>(hash) & group_mask)
+					, m_Mask(group_mask)
+				{
+				}
+
+				usize get_offset() const { return m_Group * Group::WIDTH; }
+
+				void next()
+				{
+					++m_Step;
+					m_Group = (m_Group + m_Step) & m_Mask;
+				}
+
+			private:
+				usize m_Group;
+				usize m_Mask;
+				usize m_Step{};
+			};
+
+			static ControlByte* get_empty_group()
+			{
+				// Never written, tables without slots grow before they insert
+				return const_cast<ControlByte*>(EMPTY_GROUP.data());
+			}
+
+			static constexpr usize get_max_load(const usize capacity) { return capacity - capacity / 8; }
+
+			// The control bytes come first, padded to whole slots so the slots stay aligned
+			static constexpr usize get_num_control_slots(const usize capacity) { return (capacity + sizeof(value_type) - 1) / sizeof(value_type); }
+
+			template <typename K>
+			u64 hash_key(const K& key) const
+			{
+				return mix_hash(static_cast<u64>(m_Hash(key)));
+			}
+
+			template <typename Value>
+			std::pair<iterator, bool> emplace_value(const key_type& key, Value&& value)
+			{
+				const auto [index, inserted] = find_or_prepare_insert(key);
+				if (inserted)
+					construct_at(index, std::forward<Value>(value));
+
+				return { make_iterator(index, false), inserted };
+			}
+
+			usize find_free_slot(const u64 hash) const
+			{
+				for (ProbeSequence probe(hash, m_GroupMask);; probe.next())
+				{
+					if (const auto free_slots = Group(m_Control + probe.get_offset()).match_free())
+						return probe.get_offset() + free_slots.lowest();
+				}
+			}
+
+			usize prepare_insert(const u64 hash)
+			{
+				usize index = find_free_slot(hash);
+				if (m_GrowthLeft == 0 && m_Control[index] != CONTROL_DELETED) [[unlikely]]
+				{
+					grow();
+					index = find_free_slot(hash);
+				}
+
+				if (m_Control[index] == CONTROL_EMPTY)
+					--m_GrowthLeft;
+
+				m_Control[index] = static_cast<ControlByte>(get_h2(hash));
+				++m_Size;
+				return index;
+			}
+
+			void grow()
+			{
+				// Mostly deleted slots are dropped by a rehash at the same size
+				if (m_Capacity != 0 && m_Size * 2 <= get_max_load(m_Capacity))
+				{
+					resize(m_Capacity);
+				}
+				else
+				{
+					resize(m_Capacity != 0 ? m_Capacity * 2 : Group::WIDTH);
+				}
+			}
+
+			void resize(const usize capacity)
+			{
+				ControlByte* old_control = m_Control;
+				value_type*	 old_slots = m_Slots;
+				const usize	 old_capacity = m_Capacity;
+
+				value_type* storage = AllocatorTraits::allocate(m_Allocator, get_num_control_slots(capacity) + capacity);
+				m_Control = reinterpret_cast<ControlByte*>(storage);
+				m_Slots = storage + get_num_control_slots(capacity);
+				m_Capacity = capacity;
+				m_GroupMask = capacity / Group::WIDTH - 1;
+				m_GrowthLeft = get_max_load(capacity) - m_Size;
+				std::fill_n(m_Control, capacity, CONTROL_EMPTY);
+
+				for (usize index = 0; index < old_capacity; ++index)
+				{
+					if (!is_full(old_control[index]))
+						continue;
+
+					const u64	hash = hash_key(Policy::get_key(old_slots[index]));
+					const usize new_index = find_free_slot(hash);
+					m_Control[new_index] = static_cast<ControlByte>(get_h2(hash));
+					relocate(old_slots + index, m_Slots + new_index);
+				}
+
+				if (old_capacity != 0)
+					AllocatorTraits::deallocate(m_Allocator, reinterpret_cast<value_type*>(old_control), get_num_control_slots(old_capacity) + old_capacity);
+			}
+
+			static void relocate(value_type* source, value_type* target)
+			{
+				if constexpr (Policy::RELOCATE_BYTES)
+				{
+					std::memcpy(static_cast<void*>(target), static_cast<const void*>(source), sizeof(value_type));
+				}
+				else
+				{
+					std::construct_at(target, std::move(*source));
+					std::destroy_at(source);
+				}
+			}
+
+			template <typename K>
+			usize erase_key(const K& key)
+			{
+				const usize index = find_index(key);
+				if (index == m_Capacity)
+					return 0;
+
+				erase_index(index);
+				return 1;
+			}
+
+			void erase_index(const usize index)
+			{
+				std::destroy_at(m_Slots + index);
+				--m_Size;
+
+				// Lookups only continue past groups without empty slots, so a slot can turn empty again if its group has one left
+				if (Group(m_Control + (index & ~usize{ Group::WIDTH - 1 })).match_empty())
+				{
+					m_Control[index] = CONTROL_EMPTY;
+					++m_GrowthLeft;
+				}
+				else
+				{
+					m_Control[index] = CONTROL_DELETED;
+				}
+			}
+
+			void copy_elements(const FlatHashTable& other)
+			{
+				if (other.m_Size == 0)
+					return;
+
+				reserve(other.m_Size);
+				for (usize index = 0; index < other.m_Capacity; ++index)
+				{
+					if (!is_full(other.m_Control[index]))
+						continue;
+
+					const value_type& value = other.m_Slots[index];
+					construct_at(prepare_insert(hash_key(Policy::get_key(value))), value);
+				}
+			}
+
+			void destroy_elements() noexcept
+			{
+				if constexpr (!std::is_trivially_destructible_v<value_type>)
+				{
+					for (usize index = 0; index < m_Capacity; ++index)
+					{
+						if (is_full(m_Control[index]))
+							std::destroy_at(m_Slots + index);
+					}
+				}
+			}
+
+			void destroy_storage() noexcept
+			{
+				if (m_Capacity == 0)
+					return;
+
+				destroy_elements();
+				AllocatorTraits::deallocate(m_Allocator, reinterpret_cast<value_type*>(m_Control), get_num_control_slots(m_Capacity) + m_Capacity);
+				m_Control = get_empty_group();
+				m_Slots = nullptr;
+				m_Capacity = 0;
+				m_GroupMask = 0;
+				m_Size = 0;
+				m_GrowthLeft = 0;
+			}
+
+			void steal_storage(FlatHashTable& other) noexcept
+			{
+				m_Control = std::exchange(other.m_Control, get_empty_group());
+				m_Slots = std::exchange(other.m_Slots, nullptr);
+				m_Capacity = std::exchange(other.m_Capacity, 0);
+				m_GroupMask = std::exchange(other.m_GroupMask, 0);
+				m_Size = std::exchange(other.m_Size, 0);
+				m_GrowthLeft = std::exchange(other.m_GrowthLeft, 0);
+			}
+
+			ControlByte* m_Control = get_empty_group();
+			value_type*	 m_Slots{};
+			usize		 m_Capacity{};
+			usize		 m_GroupMask{};
+			usize		 m_Size{};
+			usize		 m_GrowthLeft{};
+
+			[[no_unique_address]] Hash			 m_Hash{};
+			[[no_unique_address]] KeyEqual		 m_Equal{};
+			[[no_unique_address]] allocator_type m_Allocator{};
+		};
+
+		template <typename Key, typename T>
+		struct FlatHashMapPolicy
+		{
+			using key_type = Key;
+			using value_type = std::pair<const Key, T>;
+
+			static constexpr bool CONST_ELEMENTS = false;
+			static constexpr bool RELOCATE_BYTES = is_trivially_relocatable_v<Key> && is_trivially_relocatable_v<T>;
+
+			static const Key& get_key(const value_type& value) { return value.first; }
+		};
+
+		template <typename Key>
+		struct FlatHashSetPolicy
+		{
+			using key_type = Key;
+			using value_type = Key;
+
+			static constexpr bool CONST_ELEMENTS = true;
+			static constexpr bool RELOCATE_BYTES = is_trivially_relocatable_v<Key>;
+
+			static const Key& get_key(const value_type& value) { return value; }
+		};
+	} // namespace detail
+
+	/**
+	 * Hash map with the elements in a flat array of slots instead of a node per element, see detail::FlatHashTable.
+	 * Inserting may move the elements, so unlike std::unordered_map it invalidates references and iterators to them. Erasing doesn't.
+	 * With a transparent Hash and KeyEqual (e.g. StringHash and std::equal_to<>) keys are searched without converting them to Key.
+	 */
+	template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, typename Allocator = DefaultAllocator<std::pair<const Key, T>>>
+	class FlatHashMap : public detail::FlatHashTable<detail::FlatHashMapPolicy<Key, T>, Hash, KeyEqual, Allocator>
+	{
+		using Base = detail::FlatHashTable<detail::FlatHashMapPolicy<Key, T>, Hash, KeyEqual, Allocator>;
+
+	public:
+		using mapped_type = T;
+		using typename Base::const_iterator;
+		using typename Base::iterator;
+		using typename Base::key_type;
+		using typename Base::value_type;
+
+		using Base::Base;
+		using Base::operator=;
+
+		T& operator[](const Key& key) { return try_emplace(key).first->second; }
+		T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+		T&		 at(const Key& key) { return get_existing(this->find_index(key)); }
+		const T& at(const Key& key) const { return get_existing(this->find_index(key)); }
+
+		template <typename K>
+			requires requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; }
+		T& at(const K& key)
+		{
+			return get_existing(this->find_index(key));
+		}
+
+		template <typename K>
+			requires requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; }
+		const T& at(const K& key) const
+		{
+			return get_existing(this->find_index(key));
+		}
+
+		/** Inserts T(args...) unless the key is there already. Nothing is constructed or moved from then. */
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			return try_emplace_key(key, key, std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+		{
+			return try_emplace_key(key, std::move(key), std::forward<Args>(args)...);
+		}
+
+		/** Heterogeneous try_emplace(), which only converts the key to Key when it's inserted. */
+		template <typename K, typename... Args>
+			requires requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; } && std::is_constructible_v<Key, K&&> && (!std::is_convertible_v<K &&, const Key&>)
+		std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+		{
+			return try_emplace_key(key, std::forward<K>(key), std::forward<Args>(args)...);
+		}
+
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(const Key& key, M&& value)
+		{
+			auto result = try_emplace(key, std::forward<M>(value));
+			if (!result.second)
+				result.first->second = std::forward<M>(value);
+
+			return result;
+		}
+
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(Key&& key, M&& value)
+		{
+			auto result = try_emplace(std::move(key), std::forward<M>(value));
+			if (!result.second)
+				result.first->second = std::forward<M>(value);
+
+			return result;
+		}
+
+	private:
+		template <typename LookupKey, typename KeyArg, typename... Args>
+		std::pair<iterator, bool> try_emplace_key(const LookupKey& lookup_key, KeyArg&& key, Args&&... args)
+		{
+			const auto [index, inserted] = this->find_or_prepare_insert(lookup_key);
+			if (inserted)
+				this->construct_at(index, std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArg>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+
+			return { this->make_iterator(index, false), inserted };
+		}
+
+		T& get_existing(const usize index) const
+		{
+			if (index == this->capacity())
+				throw std::out_of_range("FlatHashMap::at: key not found");
+
+			return this->get_slot(index).second;
+		}
+	};
+
+	/** Hash set counterpart of FlatHashMap. Its elements are constant, they can only be erased and inserted again. */
+	template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>, typename Allocator = DefaultAllocator<Key>>
+	class FlatHashSet : public detail::FlatHashTable<detail::FlatHashSetPolicy<Key>, Hash, KeyEqual, Allocator>
+	{
+		using Base = detail::FlatHashTable<detail::FlatHashSetPolicy<Key>, Hash, KeyEqual, Allocator>;
+
+	public:
+		using Base::Base;
+		using Base::operator=;
+	};
+
+	/** Maps with string keys, which can be searched with string views and literals. */
+	template <typename T, typename Allocator = DefaultAllocator<std::pair<const std::string, T>>>
+	using StringMap = FlatHashMap<std::string, T, StringHash, std::equal_to<>, Allocator>;
+
+	template <typename Allocator = DefaultAllocator<std::string>>
+	using StringSet = FlatHashSet<std::string, StringHash, std::equal_to<>, Allocator>;
+} // namespace aw::core
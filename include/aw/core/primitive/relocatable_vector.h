@@ -0,0 +1,256 @@
+#pragma once
+
+#include "aw/core/memory/memalloc.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace aw::core
+{
+	/**
+	 * Whether an object can be moved to another address by copying its bytes, without running its move constructor and destructor.
+	 * True for trivially copyable types. Specialize it for types that don't point into themselves, e.g. a handle that owns a heap allocation.
+	 */
+	template <typename T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T>
+	{
+	};
+
+	template <typename T>
+	inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+	/**
+	 * Dynamic array of trivially relocatable elements, which grows its buffer with reallocate_memory().
+	 * The elements are never moved one by one. A buffer that can grow in place keeps them where they are, otherwise the pool copies
+	 * the bytes, or remaps the pages of big buffers. The capacity covers the whole block, so growing only goes to the pool once it's full.
+	 */
+	template <typename T>
+	class RelocatableVector
+	{
+		static_assert(is_trivially_relocatable_v<T>, "The elements are moved by copying their bytes.");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "reallocate_memory() doesn't keep over-aligned memory aligned.");
+
+	public:
+		using value_type = T;
+		using size_type = usize;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		RelocatableVector() noexcept = default;
+
+		explicit RelocatableVector(const usize count) { resize(count); }
+
+		RelocatableVector(const usize count, const T& value) { resize(count, value); }
+
+		RelocatableVector(std::initializer_list<T> values)
+		{
+			reserve(values.size());
+			std::uninitialized_copy(values.begin(), values.end(), m_Data);
+			m_Size = values.size();
+		}
+
+		RelocatableVector(const RelocatableVector& other)
+		{
+			reserve(other.m_Size);
+			std::uninitialized_copy(other.begin(), other.end(), m_Data);
+			m_Size = other.m_Size;
+		}
+
+		RelocatableVector(RelocatableVector&& other) noexcept
+			: m_Data(std::exchange(other.m_Data, nullptr))
+			, m_Size(std::exchange(other.m_Size, 0))
+			, m_CapacityBytes(std::exchange(other.m_CapacityBytes, 0))
+		{
+		}
+
+		~RelocatableVector()
+		{
+			clear();
+			free_memory(m_Data, m_CapacityBytes);
+		}
+
+		RelocatableVector& operator=(const RelocatableVector& other)
+		{
+			if (this != &other)
+			{
+				RelocatableVector copy(other);
+				swap(copy);
+			}
+
+			return *this;
+		}
+
+		RelocatableVector& operator=(RelocatableVector&& other) noexcept
+		{
+			RelocatableVector moved(std::move(other));
+			swap(moved);
+			return *this;
+		}
+
+		void swap(RelocatableVector& other) noexcept
+		{
+			std::swap(m_Data, other.m_Data);
+			std::swap(m_Size, other.m_Size);
+			std::swap(m_CapacityBytes, other.m_CapacityBytes);
+		}
+
+		T*		 data() noexcept { return m_Data; }
+		const T* data() const noexcept { return m_Data; }
+
+		usize size() const noexcept { return m_Size; }
+		usize capacity() const noexcept { return m_CapacityBytes / sizeof(T); }
+		bool  empty() const noexcept { return m_Size == 0; }
+
+		iterator	   begin() noexcept { return m_Data; }
+		iterator	   end() noexcept { return m_Data + m_Size; }
+		const_iterator begin() const noexcept { return m_Data; }
+		const_iterator end() const noexcept { return m_Data + m_Size; }
+
+		T&		 operator[](const usize index) { return m_Data[index]; }
+		const T& operator[](const usize index) const { return m_Data[index]; }
+
+		T&		 front() { return m_Data[0]; }
+		const T& front() const { return m_Data[0]; }
+		T&		 back() { return m_Data[m_Size - 1]; }
+		const T& back() const { return m_Data[m_Size - 1]; }
+
+		void reserve(const usize new_capacity)
+		{
+			if (new_capacity > capacity())
+				reallocate(new_capacity);
+		}
+
+		void resize(const usize new_size)
+		{
+			if (new_size < m_Size)
+			{
+				std::destroy(m_Data + new_size, m_Data + m_Size);
+			}
+			else
+			{
+				reserve(new_size);
+				std::uninitialized_value_construct(m_Data + m_Size, m_Data + new_size);
+			}
+
+			m_Size = new_size;
+		}
+
+		void resize(const usize new_size, const T& value)
+		{
+			if (new_size < m_Size)
+			{
+				std::destroy(m_Data + new_size, m_Data + m_Size);
+			}
+			else
+			{
+				// The value may live in the buffer, so it's copied before the buffer moves
+				const T copy = value;
+				reserve(new_size);
+				std::uninitialized_fill(m_Data + m_Size, m_Data + new_size, copy);
+			}
+
+			m_Size = new_size;
+		}
+
+		void push_back(const T& value) { emplace_back(value); }
+
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (m_Size < capacity()) [[likely]]
+			{
+				return *std::construct_at(m_Data + m_Size++, std::forward<Args>(args)...);
+			}
+
+			// The arguments may point into the buffer, so the element is built before the buffer moves and relocated into it afterwards
+			alignas(T) std::byte element[sizeof(T)];
+			T*					 constructed = std::construct_at(reinterpret_cast<T*>(element), std::forward<Args>(args)...);
+			try
+			{
+				grow(m_Size + 1);
+			}
+			catch (...)
+			{
+				std::destroy_at(constructed);
+				throw;
+			}
+
+			std::memcpy(static_cast<void*>(m_Data + m_Size), element, sizeof(T));
+			return m_Data[m_Size++];
+		}
+
+		void pop_back()
+		{
+			std::destroy_at(m_Data + --m_Size);
+		}
+
+		iterator erase(const_iterator position)
+		{
+			T* element = m_Data + (position - m_Data);
+			std::destroy_at(element);
+			std::memmove(static_cast<void*>(element), element + 1, (end() - element - 1) * sizeof(T));
+			--m_Size;
+			return element;
+		}
+
+		void clear() noexcept
+		{
+			std::destroy(m_Data, m_Data + m_Size);
+			m_Size = 0;
+		}
+
+		/** Gives the memory beyond the size back to the pool. The elements stay in place if the buffer can shrink in place. */
+		void shrink_to_fit()
+		{
+			if (m_Size == 0)
+			{
+				free_memory(m_Data, m_CapacityBytes);
+				m_Data = nullptr;
+				m_CapacityBytes = 0;
+			}
+			else if (m_Size < capacity())
+			{
+				reallocate(m_Size);
+			}
+		}
+
+	private:
+		void grow(const usize min_capacity)
+		{
+			const usize current_capacity = capacity();
+			reallocate(std::max(min_capacity, current_capacity + current_capacity / 2));
+		}
+
+		void reallocate(const usize new_capacity)
+		{
+			if (new_capacity > std::numeric_limits<usize>::max() / sizeof(T))
+				throw std::bad_array_new_length();
+
+			void* memory = reallocate_memory(m_Data, new_capacity * sizeof(T));
+			if (!memory)
+				throw std::bad_alloc();
+
+			// The rest of the block comes for free. The usable size is also what the buffer is freed with, as it's in the same size class.
+			m_Data = static_cast<T*>(memory);
+			m_CapacityBytes = get_usable_allocation_size(memory);
+		}
+
+		T*	  m_Data{};
+		usize m_Size{};
+		usize m_CapacityBytes{};
+	};
+} // namespace aw::core
@@ -14,13 +14,21 @@ namespace aw::core
 		}
 		m_RunningTasks = m_Tasks.size();
 
+		// Collect the roots before scheduling anything. A scheduled task may finish and drop the dependencies of another task to zero
+		// before the loop gets to it, which would schedule that task twice.
+		Vector<TaskNode*> roots;
 		for (TaskNodePtr& task : m_Tasks)
 		{
 			if (task->remaining_dependencies == 0)
 			{
-				schedule_node(task.get(), pool);
+				roots.push_back(task.get());
 			}
 		}
+
+		for (TaskNode* root : roots)
+		{
+			schedule_node(root, pool);
+		}
 	}
 
 	void TaskGraph::wait_all()
@@ -2,6 +2,7 @@
 
 #include "aw/core/filesystem/virtual_file_system.h"
 #include "aw/core/memory/paged_memory_pool.h"
+#include "aw/core/primitive/flat_hash_map.h"
 #include "aw/core/primitive/numbers.h"
 
 #include <fstream>
@@ -55,6 +56,7 @@ namespace aw::core
 			m_AwpkStream = std::move(in);
 			m_AwpkStream.seekg(0, std::ios::beg);
 
+			m_ReadMappings.reserve(header.num_files);
 			for (const auto& entry : m_ReadFiles)
 			{
 				m_ReadMappings[entry.filename] = &entry;
@@ -187,7 +189,7 @@ namespace aw::core
 			std::vector<std::string> out;
 			out.reserve(m_ReadFiles.size());
 
-			if (const auto iter = m_FilesPerDirectory.find(std::string(directory)); iter != m_FilesPerDirectory.end())
+			if (const auto iter = m_FilesPerDirectory.find(directory); iter != m_FilesPerDirectory.end())
 			{
 				for (const auto& entry : iter->second)
 				{
@@ -214,10 +216,10 @@ namespace aw::core
 
 		std::unordered_map<std::string, std::string> m_WriteFileMappings{};
 		std::vector<AwpkFileEntry> m_ReadFiles{};
-		std::unordered_map<std::string_view, const AwpkFileEntry*> m_ReadMappings{};
+		FlatHashMap<std::string_view, const AwpkFileEntry*> m_ReadMappings{};
 		bool m_IsWriting = false;
 
-		std::unordered_map<std::string, std::vector<const AwpkFileEntry*>> m_FilesPerDirectory{};
+		StringMap<std::vector<const AwpkFileEntry*>> m_FilesPerDirectory{};
 
 		std::mutex m_Mutex{};
 	};
@@ -34,7 +34,7 @@ namespace aw::core
 		if (const auto pos = path.find(s_vfs_divider); pos != std::string_view::npos)
 		{
 			const std::string_view mapping = path.substr(0, pos + s_vfs_divider.length());
-			if (const auto iter = m_Mappings.find(std::string(mapping)); iter != m_Mappings.end())
+			if (const auto iter = m_Mappings.find(mapping); iter != m_Mappings.end())
 			{
 				std::string final_path = std::format("{}/{}", iter->second, path.substr(pos + s_vfs_divider.length()));
 				return final_path;
@@ -0,0 +1,323 @@
+#include "aw/core/memory/buddy_allocator.h"
+
+#include "aw/core/memory/paged_memory_pool.h"
+#include "aw/core/memory/virtual_memory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+namespace aw::core
+{
+	// Blocks have to start at page boundaries and hold their allocation in the first page, so masking the address finds the block
+	static_assert(BuddyAllocator::MIN_BLOCK_SIZE == DEFAULT_PAGE_SIZE);
+
+	MemoryPage* BuddyAllocator::allocate(const u64 used_size)
+	{
+		assert(fits(used_size));
+		const u64 order = get_order(used_size);
+		const u64 required_size = Math::align_up(used_size, VirtualMemory::get_page_size());
+
+		std::lock_guard lock(m_Mutex);
+		u64				block_order = find_free_order(order);
+		if (block_order == NUM_ORDERS && coalesce())
+			block_order = find_free_order(order);
+
+		MemoryPage* block;
+		if (block_order < NUM_ORDERS)
+		{
+			block = m_FreeBlocks[block_order];
+			remove_free_block(block, block_order);
+		}
+		else
+		{
+			block = create_arena();
+			if (!block)
+				return nullptr;
+
+			block->m_BuddyFree = false;
+			block_order = NUM_ORDERS - 1;
+		}
+
+		// Split the block down to the requested order, the upper halves go to the free lists
+		while (block_order > order)
+		{
+			--block_order;
+			const u64 half_size = get_order_size(block_order);
+			const u64 committed_size = block->m_CommittedSize;
+			u8*		  upper = reinterpret_cast<u8*>(block) + half_size;
+			u64		  upper_committed_size = committed_size > half_size ? committed_size - half_size : 0;
+			if (upper_committed_size == 0)
+			{
+				// The free block needs its page to be linked into the list
+				upper_committed_size = VirtualMemory::get_page_size();
+				if (!VirtualMemory::commit(upper, upper_committed_size))
+				{
+					push_free_block(make_free_block(block, block->m_BuddyBlockSize, committed_size), block_order + 1);
+					return nullptr;
+				}
+
+				m_CommittedBytes += upper_committed_size;
+				PagedMemoryPool::on_committed(upper_committed_size);
+			}
+
+			push_free_block(make_free_block(upper, half_size, upper_committed_size), block_order);
+			block->m_BuddyBlockSize = half_size;
+			block->m_CommittedSize = std::min(committed_size, half_size);
+		}
+
+		u64 committed_size = block->m_CommittedSize;
+		if (committed_size < required_size)
+		{
+			if (!VirtualMemory::commit(reinterpret_cast<u8*>(block) + committed_size, required_size - committed_size))
+			{
+				push_free_block(make_free_block(block, block->m_BuddyBlockSize, committed_size), order);
+				return nullptr;
+			}
+
+			m_CommittedBytes += required_size - committed_size;
+			PagedMemoryPool::on_committed(required_size - committed_size);
+			committed_size = required_size;
+		}
+		else
+		{
+			++m_RecycledAllocations;
+		}
+
+		// Memory committed beyond the allocation stays with the block and is reused once the block gets freed again
+		const u64 block_size = get_order_size(order);
+		std::destroy_at(block);
+		std::construct_at(block, nullptr, used_size - MemoryPage::get_blocks_offset(), committed_size);
+		block->m_BuddyBlockSize = block_size;
+
+		++m_LiveAllocations;
+		++m_TotalAllocations;
+		m_LiveBlockBytes += block_size;
+		return block;
+	}
+
+	void BuddyAllocator::free(MemoryPage* page)
+	{
+		assert(page->is_buddy_block() && !page->m_BuddyFree);
+		std::lock_guard lock(m_Mutex);
+		--m_LiveAllocations;
+		m_LiveBlockBytes -= page->m_BuddyBlockSize;
+
+		// Merging is left to the next allocation that finds no free block, so a buffer that is freed and allocated again doesn't split and merge its arena every time
+		const u64 block_size = page->m_BuddyBlockSize;
+		const u64 committed_size = page->m_CommittedSize;
+		std::destroy_at(page);
+		push_free_block(make_free_block(page, block_size, committed_size), get_order(block_size));
+	}
+
+	bool BuddyAllocator::commit(MemoryPage* page, const u64 used_size)
+	{
+		assert(used_size <= page->m_BuddyBlockSize);
+		const u64 required_size = Math::align_up(used_size, VirtualMemory::get_page_size());
+		if (required_size <= page->m_CommittedSize)
+			return true;
+
+		std::lock_guard lock(m_Mutex);
+		const u64		committed_size = page->m_CommittedSize;
+		if (!VirtualMemory::commit(reinterpret_cast<u8*>(page) + committed_size, required_size - committed_size))
+			return false;
+
+		m_CommittedBytes += required_size - committed_size;
+		PagedMemoryPool::on_committed(required_size - committed_size);
+		page->m_CommittedSize = required_size;
+		return true;
+	}
+
+	u64 BuddyAllocator::trim()
+	{
+		const u64		page_size = VirtualMemory::get_page_size();
+		u64				released_size = 0;
+		std::lock_guard lock(m_Mutex);
+		coalesce();
+
+		// Free arenas are only kept for reuse, nothing else points into them
+		while (MemoryPage* arena = m_FreeBlocks[NUM_ORDERS - 1])
+		{
+			remove_free_block(arena, NUM_ORDERS - 1);
+			released_size += arena->m_CommittedSize;
+			m_CommittedBytes -= arena->m_CommittedSize;
+			PagedMemoryPool::on_decommitted(arena->m_CommittedSize);
+			--m_NumArenas;
+			std::destroy_at(arena);
+			VirtualMemory::release(arena, MAX_BLOCK_SIZE);
+		}
+
+		for (MemoryPage* block : m_FreeBlocks)
+		{
+			for (; block; block = block->m_Next)
+			{
+				if (block->m_CommittedSize <= page_size)
+					continue;
+
+				const u64 decommitted_size = block->m_CommittedSize - page_size;
+				VirtualMemory::decommit(reinterpret_cast<u8*>(block) + page_size, decommitted_size);
+				block->m_CommittedSize = page_size;
+				m_CommittedBytes -= decommitted_size;
+				PagedMemoryPool::on_decommitted(decommitted_size);
+				released_size += decommitted_size;
+			}
+		}
+
+		return released_size;
+	}
+
+	BuddyStats BuddyAllocator::stats() const
+	{
+		BuddyStats		stats{};
+		std::lock_guard lock(m_Mutex);
+		stats.num_arenas = m_NumArenas;
+		stats.committed_bytes = m_CommittedBytes;
+		stats.live_allocations = m_LiveAllocations;
+		stats.total_allocations = m_TotalAllocations;
+		stats.recycled_allocations = m_RecycledAllocations;
+		stats.live_block_bytes = m_LiveBlockBytes;
+		for (u64 order = 0; order < NUM_ORDERS; ++order)
+		{
+			stats.free_blocks[order] = m_NumFreeBlocks[order];
+			stats.free_block_bytes += m_NumFreeBlocks[order] * get_order_size(order);
+		}
+
+		return stats;
+	}
+
+	MemoryPage* BuddyAllocator::create_arena()
+	{
+		// Aligned to its size, so the buddy of a block is found by flipping a bit of its offset
+		void* memory = VirtualMemory::reserve(MAX_BLOCK_SIZE, MAX_BLOCK_SIZE);
+		if (!memory)
+			return nullptr;
+
+		if (PagedMemoryPool::are_huge_pages_enabled())
+			VirtualMemory::advise_huge_pages(memory, MAX_BLOCK_SIZE);
+
+		const u64 committed_size = VirtualMemory::get_page_size();
+		if (!VirtualMemory::commit(memory, committed_size))
+		{
+			VirtualMemory::release(memory, MAX_BLOCK_SIZE);
+			return nullptr;
+		}
+
+		++m_NumArenas;
+		m_CommittedBytes += committed_size;
+		PagedMemoryPool::on_committed(committed_size);
+		return make_free_block(memory, MAX_BLOCK_SIZE, committed_size);
+	}
+
+	u64 BuddyAllocator::find_free_order(const u64 order) const
+	{
+		u64 free_order = order;
+		while (free_order < NUM_ORDERS && !m_FreeBlocks[free_order])
+		{
+			++free_order;
+		}
+
+		return free_order;
+	}
+
+	bool BuddyAllocator::coalesce()
+	{
+		bool merged = false;
+		for (u64 order = 0; order + 1 < NUM_ORDERS; ++order)
+		{
+			const u64	block_size = get_order_size(order);
+			MemoryPage* block = m_FreeBlocks[order];
+			while (block)
+			{
+				// The buddy starts a block of its size or smaller, so its page is always committed
+				const auto arena = reinterpret_cast<std::uintptr_t>(block) & ~(MAX_BLOCK_SIZE - 1);
+				const auto buddy = reinterpret_cast<MemoryPage*>(arena + ((reinterpret_cast<std::uintptr_t>(block) - arena) ^ block_size));
+				MemoryPage* next = block->m_Next;
+				if (!buddy->m_BuddyFree || buddy->m_BuddyBlockSize != block_size)
+				{
+					block = next;
+					continue;
+				}
+
+				if (next == buddy)
+					next = buddy->m_Next;
+
+				remove_free_block(block, order);
+				remove_free_block(buddy, order);
+				merge_blocks(std::min(block, buddy), std::max(block, buddy), order);
+				merged = true;
+				block = next;
+			}
+		}
+
+		return merged;
+	}
+
+	void BuddyAllocator::merge_blocks(MemoryPage* lower, MemoryPage* upper, const u64 order)
+	{
+		const u64 block_size = get_order_size(order);
+		const u64 lower_committed_size = lower->m_CommittedSize;
+		const u64 upper_committed_size = upper->m_CommittedSize;
+		std::destroy_at(lower);
+		std::destroy_at(upper);
+
+		// The committed memory of a free block is always a prefix of it. If the lower half has a gap, the memory of the upper half goes back to the OS.
+		u64 committed_size = lower_committed_size;
+		if (lower_committed_size == block_size)
+		{
+			committed_size += upper_committed_size;
+		}
+		else
+		{
+			VirtualMemory::decommit(upper, upper_committed_size);
+			m_CommittedBytes -= upper_committed_size;
+			PagedMemoryPool::on_decommitted(upper_committed_size);
+		}
+
+		// Keep a single free arena around, the others go back to the OS
+		if (order + 1 == NUM_ORDERS - 1 && m_FreeBlocks[NUM_ORDERS - 1])
+		{
+			m_CommittedBytes -= committed_size;
+			PagedMemoryPool::on_decommitted(committed_size);
+			--m_NumArenas;
+			VirtualMemory::release(lower, MAX_BLOCK_SIZE);
+			return;
+		}
+
+		push_free_block(make_free_block(lower, 2 * block_size, committed_size), order + 1);
+	}
+
+	MemoryPage* BuddyAllocator::make_free_block(void* address, const u64 block_size, const u64 committed_size)
+	{
+		MemoryPage* block = std::construct_at(static_cast<MemoryPage*>(address), nullptr, block_size - MemoryPage::get_blocks_offset(), committed_size);
+		block->m_BuddyBlockSize = block_size;
+		block->m_BuddyFree = true;
+		return block;
+	}
+
+	void BuddyAllocator::push_free_block(MemoryPage* block, const u64 order)
+	{
+		block->m_Prev = nullptr;
+		block->m_Next = m_FreeBlocks[order];
+		if (block->m_Next)
+			block->m_Next->m_Prev = block;
+
+		m_FreeBlocks[order] = block;
+		++m_NumFreeBlocks[order];
+	}
+
+	void BuddyAllocator::remove_free_block(MemoryPage* block, const u64 order)
+	{
+		if (block->m_Prev)
+			block->m_Prev->m_Next = block->m_Next;
+		else
+			m_FreeBlocks[order] = block->m_Next;
+
+		if (block->m_Next)
+			block->m_Next->m_Prev = block->m_Prev;
+
+		block->m_Prev = nullptr;
+		block->m_Next = nullptr;
+		block->m_BuddyFree = false;
+		--m_NumFreeBlocks[order];
+	}
+} // namespace aw::core
@@ -0,0 +1,268 @@
+#include "aw/core/memory/heap_profiler.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <execinfo.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <mutex>
+
+namespace aw::core
+{
+	namespace
+	{
+		// How often a thread checks whether the profiler got enabled while it's disabled
+		constexpr u64 DISABLED_RECHECK_BYTES = 64 * 1024;
+
+		// Frames of the profiler and the pool on top of every stack
+		constexpr u32 SKIPPED_FRAMES = 2;
+
+		constexpr u64 NUM_BUCKETS = 4096;
+
+		struct Sample
+		{
+			const void* key{};
+			u64			size{};
+			u64			estimated_bytes{};
+			u32			num_frames{};
+			void*		frames[HeapProfiler::MAX_FRAMES]{};
+			Sample*		next{};
+		};
+
+		// The samples are malloc'ed and kept in a table of their own, so recording one never goes back into the pool
+		struct SampleTable
+		{
+			std::mutex						 mutex{};
+			std::array<Sample*, NUM_BUCKETS> buckets{};
+		};
+
+		// Never destroyed, the samples are dumped at exit. Built in static storage, as operator new may be served by the pool.
+		SampleTable& get_table()
+		{
+			alignas(SampleTable) static std::byte storage[sizeof(SampleTable)];
+			static SampleTable*				  table = std::construct_at(reinterpret_cast<SampleTable*>(storage));
+			return *table;
+		}
+
+		u64 get_bucket_index(const void* key)
+		{
+			return (reinterpret_cast<std::uintptr_t>(key) * 0x9E3779B97F4A7C15ull) >> (64 - std::countr_zero(NUM_BUCKETS));
+		}
+
+		thread_local bool t_Armed = false;
+		thread_local u64  t_RandomState = 0;
+
+		u64 next_random()
+		{
+			if (t_RandomState == 0)
+			{
+				t_RandomState = (reinterpret_cast<std::uintptr_t>(&t_RandomState) ^ static_cast<u64>(std::chrono::steady_clock::now().time_since_epoch().count())) | 1;
+			}
+
+			// xorshift64*
+			t_RandomState ^= t_RandomState >> 12;
+			t_RandomState ^= t_RandomState << 25;
+			t_RandomState ^= t_RandomState >> 27;
+			return t_RandomState * 0x2545F4914F6CDD1Dull;
+		}
+
+		// Exponentially distributed with a mean of 'interval'
+		u64 draw_bytes_until_sample(const u64 interval)
+		{
+			const f64 uniform = static_cast<f64>(next_random() >> 11) * 0x1.0p-53;
+			return static_cast<u64>(-std::log(1.0 - uniform) * static_cast<f64>(interval)) + 1;
+		}
+
+		u32 capture_stack(void** frames)
+		{
+			void* captured[HeapProfiler::MAX_FRAMES + SKIPPED_FRAMES];
+#ifdef _WIN32
+			const u32 num_captured = CaptureStackBackTrace(0, HeapProfiler::MAX_FRAMES + SKIPPED_FRAMES, captured, nullptr);
+#else
+			const u32 num_captured = static_cast<u32>(std::max(backtrace(captured, HeapProfiler::MAX_FRAMES + SKIPPED_FRAMES), 0));
+#endif
+			const u32 num_frames = num_captured > SKIPPED_FRAMES ? num_captured - SKIPPED_FRAMES : 0;
+			std::copy_n(captured + (num_captured - num_frames), num_frames, frames);
+			return num_frames;
+		}
+	} // namespace
+
+	void HeapProfiler::set_sample_interval(const u64 interval)
+	{
+		s_SampleInterval.store(interval, std::memory_order::relaxed);
+		t_Armed = interval != 0;
+		t_BytesUntilSample = interval != 0 ? draw_bytes_until_sample(interval) : DISABLED_RECHECK_BYTES;
+	}
+
+	bool HeapProfiler::on_countdown_expired()
+	{
+		const u64 interval = get_sample_interval();
+		if (interval == 0)
+		{
+			t_Armed = false;
+			t_BytesUntilSample = DISABLED_RECHECK_BYTES;
+			return false;
+		}
+
+		t_BytesUntilSample = draw_bytes_until_sample(interval);
+
+		// The countdown of a new thread, or of a thread that was waiting for the profiler to get enabled, wasn't drawn from the interval.
+		// Sampling the allocation would overcount it.
+		if (!t_Armed)
+		{
+			t_Armed = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	void HeapProfiler::record_allocation(const void* key, const u64 size)
+	{
+		const auto sample = static_cast<Sample*>(malloc(sizeof(Sample)));
+		if (!sample)
+			return;
+
+		std::construct_at(sample);
+		sample->key = key;
+		sample->size = size;
+		sample->num_frames = capture_stack(sample->frames);
+
+		// The probability of an allocation of this size being sampled is 1 - e^(-size / interval), so it stands for 1 / p allocations
+		const f64 interval = static_cast<f64>(std::max<u64>(get_sample_interval(), 1));
+		const f64 probability = 1.0 - std::exp(-static_cast<f64>(size) / interval);
+		sample->estimated_bytes = static_cast<u64>(static_cast<f64>(size) / std::max(probability, 1e-12));
+
+		SampleTable&	table = get_table();
+		std::lock_guard lock(table.mutex);
+		Sample*&		bucket = table.buckets[get_bucket_index(key)];
+		sample->next = bucket;
+		bucket = sample;
+		s_NumLiveSamples.fetch_add(1, std::memory_order::relaxed);
+	}
+
+	bool HeapProfiler::record_free(const void* key)
+	{
+		Sample* found = nullptr;
+		{
+			SampleTable&	table = get_table();
+			std::lock_guard lock(table.mutex);
+			for (Sample** link = &table.buckets[get_bucket_index(key)]; *link; link = &(*link)->next)
+			{
+				if ((*link)->key == key)
+				{
+					found = *link;
+					*link = found->next;
+					s_NumLiveSamples.fetch_sub(1, std::memory_order::relaxed);
+					break;
+				}
+			}
+		}
+
+		if (!found)
+			return false;
+
+		std::destroy_at(found);
+		free(found);
+		return true;
+	}
+
+	std::vector<HeapProfiler::CallSite> HeapProfiler::get_live_call_sites()
+	{
+		// Copying a sample into a call site never allocates, so a free of the pool can't come back for the lock while it's held
+		std::vector<CallSite> samples(get_num_live_samples() + 64);
+		usize				  num_samples = 0;
+		{
+			SampleTable&	table = get_table();
+			std::lock_guard lock(table.mutex);
+			for (const Sample* bucket : table.buckets)
+			{
+				for (const Sample* sample = bucket; sample && num_samples < samples.size(); sample = sample->next)
+				{
+					CallSite& site = samples[num_samples++];
+					std::copy_n(sample->frames, sample->num_frames, site.frames.begin());
+					site.num_frames = sample->num_frames;
+					site.num_samples = 1;
+					site.sampled_bytes = sample->size;
+					site.estimated_bytes = sample->estimated_bytes;
+				}
+			}
+		}
+		samples.resize(num_samples);
+
+		const auto by_stack = [](const CallSite& lhs, const CallSite& rhs) {
+			return std::lexicographical_compare(lhs.frames.begin(), lhs.frames.begin() + lhs.num_frames, rhs.frames.begin(), rhs.frames.begin() + rhs.num_frames);
+		};
+		std::ranges::sort(samples, by_stack);
+
+		std::vector<CallSite> sites;
+		for (const CallSite& sample : samples)
+		{
+			if (sites.empty() || by_stack(sites.back(), sample))
+			{
+				sites.push_back(sample);
+				continue;
+			}
+
+			sites.back().num_samples += sample.num_samples;
+			sites.back().sampled_bytes += sample.sampled_bytes;
+			sites.back().estimated_bytes += sample.estimated_bytes;
+		}
+
+		std::ranges::sort(sites, [](const CallSite& lhs, const CallSite& rhs) { return lhs.estimated_bytes > rhs.estimated_bytes; });
+		return sites;
+	}
+
+	std::string HeapProfiler::dump()
+	{
+		const std::vector<CallSite> sites = get_live_call_sites();
+
+		u64 num_samples = 0;
+		u64 estimated_bytes = 0;
+		for (const CallSite& site : sites)
+		{
+			num_samples += site.num_samples;
+			estimated_bytes += site.estimated_bytes;
+		}
+
+		std::string result = std::format("heap profile: {} live samples, ~{} B in {} call sites (1 sample per {} B)\n",
+			num_samples,
+			estimated_bytes,
+			sites.size(),
+			get_sample_interval());
+
+		for (const CallSite& site : sites)
+		{
+			result += std::format("~{} B in {} samples ({} B sampled)\n", site.estimated_bytes, site.num_samples, site.sampled_bytes);
+#ifdef _WIN32
+			for (u32 index = 0; index < site.num_frames; ++index)
+			{
+				result += std::format("    #{} {}\n", index, site.frames[index]);
+			}
+#else
+			char** symbols = backtrace_symbols(site.frames.data(), static_cast<int>(site.num_frames));
+			for (u32 index = 0; index < site.num_frames; ++index)
+			{
+				if (symbols)
+					result += std::format("    #{} {}\n", index, symbols[index]);
+				else
+					result += std::format("    #{} {}\n", index, site.frames[index]);
+			}
+			free(symbols);
+#endif
+		}
+
+		return result;
+	}
+} // namespace aw::core
@@ -1,7 +1,19 @@
 #include "aw/core/memory/intrusive_ref_counted.h"
 
+#include <thread>
+
 namespace aw::core
 {
+	IntrusiveRefCounted::~IntrusiveRefCounted()
+	{
+		// Runs before the memory of the object is freed, so upgrades that are still running can read the count until expire() returns
+		if (WeakRefControlBlock* control_block = m_WeakControlBlock.load(std::memory_order::acquire))
+		{
+			control_block->expire();
+			control_block->release_weak_ref();
+		}
+	}
+
 	void IntrusiveRefCounted::add_ref() const
 	{
 		m_RefCount.fetch_add(1, std::memory_order_relaxed);
@@ -10,14 +22,71 @@ namespace aw::core
 	{
 		if (m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
 		{
-			aw_delete(const_cast<IntrusiveRefCounted*>(this));
+			destroy();
 		}
 	}
+	void IntrusiveRefCounted::destroy() const
+	{
+		aw_delete(const_cast<IntrusiveRefCounted*>(this));
+	}
+
 	usize IntrusiveRefCounted::get_ref_count() const
 	{
 		return m_RefCount.load(std::memory_order_acquire);
 	}
 
+	bool IntrusiveRefCounted::try_add_ref() const
+	{
+		usize count = m_RefCount.load(std::memory_order::relaxed);
+		while (count != 0)
+		{
+			if (m_RefCount.compare_exchange_weak(count, count + 1, std::memory_order::relaxed))
+				return true;
+		}
+
+		return false;
+	}
+
+	WeakRefControlBlock* IntrusiveRefCounted::get_weak_control_block() const
+	{
+		WeakRefControlBlock* control_block = m_WeakControlBlock.load(std::memory_order::acquire);
+		if (control_block)
+			return control_block;
+
+		// Racing threads each create a block, the ones that lose give theirs back
+		WeakRefControlBlock* created = ObjectPool<WeakRefControlBlock>::get().create(this);
+		if (m_WeakControlBlock.compare_exchange_strong(control_block, created, std::memory_order::acq_rel, std::memory_order::acquire))
+			return created;
+
+		ObjectPool<WeakRefControlBlock>::get().destroy(created);
+		return control_block;
+	}
+
+	bool WeakRefControlBlock::try_lock() const
+	{
+		// Announced before the object is read, so expire() either waits for this upgrade or the upgrade sees the object is gone
+		m_NumLocking.fetch_add(1, std::memory_order::seq_cst);
+		const IntrusiveRefCounted* object = m_Object.load(std::memory_order::seq_cst);
+		const bool				   locked = object && object->try_add_ref();
+		m_NumLocking.fetch_sub(1, std::memory_order::release);
+		return locked;
+	}
+
+	void WeakRefControlBlock::release_weak_ref()
+	{
+		if (m_NumWeakRefs.fetch_sub(1, std::memory_order::acq_rel) == 1)
+			ObjectPool<WeakRefControlBlock>::get().destroy(this);
+	}
+
+	void WeakRefControlBlock::expire()
+	{
+		m_Object.store(nullptr, std::memory_order::seq_cst);
+		while (m_NumLocking.load(std::memory_order::seq_cst) != 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
 	void detail::fwd_ref_ptr_add_ref(void* ptr)
 	{
 		static_cast<IntrusiveRefCounted*>(ptr)->add_ref();
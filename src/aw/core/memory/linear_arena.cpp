@@ -0,0 +1,99 @@
+#include "aw/core/memory/linear_arena.h"
+
+#include "aw/core/memory/memalloc.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace aw::core
+{
+	LinearArena::LinearArena(const usize chunk_size)
+		: m_ChunkSize(std::max<usize>(chunk_size, 1024))
+	{
+	}
+
+	LinearArena::~LinearArena()
+	{
+		release();
+	}
+
+	void LinearArena::reset()
+	{
+		if (m_FirstChunk)
+			use_chunk(m_FirstChunk);
+	}
+
+	void LinearArena::rewind(const Marker marker)
+	{
+		// The arena had no chunk when the marker was taken, so everything after it starts at the first chunk
+		if (!marker.chunk)
+		{
+			reset();
+			return;
+		}
+
+		m_CurrentChunk = marker.chunk;
+		m_Cursor = marker.cursor;
+		m_End = marker.chunk->get_end();
+	}
+
+	void LinearArena::release()
+	{
+		while (Chunk* chunk = m_FirstChunk)
+		{
+			m_FirstChunk = chunk->next;
+			std::destroy_at(chunk);
+			free_memory(chunk);
+		}
+
+		m_CurrentChunk = nullptr;
+		m_Cursor = nullptr;
+		m_End = nullptr;
+		m_ReservedBytes = 0;
+	}
+
+	void* LinearArena::allocate_from_next_chunk(const usize size, const usize alignment)
+	{
+		const usize header_size = Math::align_up(sizeof(Chunk), alignof(std::max_align_t));
+		const usize required_size = header_size + size + (alignment > alignof(std::max_align_t) ? alignment : 0);
+		if (required_size < size)
+			return nullptr;
+
+		// After a reset, the chunks that were used before are reused in order
+		Chunk* next = m_CurrentChunk ? m_CurrentChunk->next : m_FirstChunk;
+		if (!next || next->size < required_size)
+		{
+			// Oversized allocations get a chunk of their own size
+			const usize chunk_size = std::max(m_ChunkSize, required_size);
+			next = static_cast<Chunk*>(allocate_memory(chunk_size));
+			if (!next)
+				return nullptr;
+
+			std::construct_at(next);
+			next->size = chunk_size;
+			m_ReservedBytes += chunk_size;
+
+			// The skipped chunk stays in the list and is reused after the next reset
+			if (m_CurrentChunk)
+			{
+				next->next = m_CurrentChunk->next;
+				m_CurrentChunk->next = next;
+			}
+			else
+			{
+				next->next = m_FirstChunk;
+				m_FirstChunk = next;
+			}
+		}
+
+		use_chunk(next);
+		return allocate(size, alignment);
+	}
+
+	void LinearArena::use_chunk(Chunk* chunk)
+	{
+		m_CurrentChunk = chunk;
+		m_Cursor = chunk->get_begin();
+		m_End = chunk->get_end();
+	}
+} // namespace aw::core
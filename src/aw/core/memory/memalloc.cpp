@@ -15,6 +15,41 @@ namespace aw::core
 		return PagedMemoryPool::get().allocate_memory(Bytes(size));
 	}
 
+	void* allocate_memory_aligned(const usize size, const usize alignment)
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+		return PagedMemoryPool::get().allocate_memory_aligned(Bytes(size), alignment);
+	}
+
+	void* allocate_memory(PagedMemoryPool& heap, const usize size)
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+		return heap.allocate_memory(Bytes(size));
+	}
+
+	void* allocate_memory_aligned(PagedMemoryPool& heap, const usize size, const usize alignment)
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+		return heap.allocate_memory_aligned(Bytes(size), alignment);
+	}
+
+	PagedMemoryPool& get_default_heap()
+	{
+		return PagedMemoryPool::get();
+	}
+
 	void free_memory(void* ptr)
 	{
 		if (!ptr)
@@ -25,6 +60,21 @@ namespace aw::core
 		PagedMemoryPool::get().free_memory(ptr);
 	}
 
+	void free_memory(void* ptr, const usize size)
+	{
+		if (!ptr)
+		{
+			return;
+		}
+
+		PagedMemoryPool::free_memory(ptr, Bytes(size));
+	}
+
+	void* reallocate_memory(void* ptr, const usize new_size)
+	{
+		return PagedMemoryPool::get().reallocate_memory(ptr, Bytes(new_size));
+	}
+
 	usize get_allocation_size(void* ptr)
 	{
 		if (!ptr)
@@ -34,4 +84,14 @@ namespace aw::core
 
 		return PagedMemoryPool::get().get_allocation_size(ptr);
 	}
+
+	usize get_usable_allocation_size(void* ptr)
+	{
+		if (!ptr)
+		{
+			return 0;
+		}
+
+		return PagedMemoryPool::get_usable_size(ptr);
+	}
 } // namespace aw::core
@@ -0,0 +1,90 @@
+#include "aw/core/memory/memory_tags.h"
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace aw::core
+{
+	namespace
+	{
+		struct TaggedHeap
+		{
+			explicit TaggedHeap(const std::string_view in_name)
+				: name(in_name)
+			{
+			}
+
+			std::string_view name;
+			PagedMemoryPool	 heap{};
+			TaggedHeap*		 next{};
+		};
+
+		struct TagRegistry
+		{
+			std::mutex	mutex{};
+			TaggedHeap* head{};
+			TaggedHeap* tail{};
+		};
+
+		// Never destroyed, like the heaps in it. Built in static storage, as tags can be used during static initialization.
+		TagRegistry& get_registry()
+		{
+			alignas(TagRegistry) static std::byte storage[sizeof(TagRegistry)];
+			static TagRegistry*					  registry = std::construct_at(reinterpret_cast<TagRegistry*>(storage));
+			return *registry;
+		}
+	} // namespace
+
+	PagedMemoryPool& MemoryTags::create_heap(const std::string_view name)
+	{
+		// Malloc'ed, as operator new may be served by the pool
+		const auto tagged_heap = static_cast<TaggedHeap*>(malloc(sizeof(TaggedHeap)));
+		if (!tagged_heap)
+			throw std::bad_alloc();
+
+		std::construct_at(tagged_heap, name);
+		TagRegistry&	registry = get_registry();
+		std::lock_guard lock(registry.mutex);
+		(registry.tail ? registry.tail->next : registry.head) = tagged_heap;
+		registry.tail = tagged_heap;
+		return tagged_heap->heap;
+	}
+
+	std::vector<MemoryTagStats> MemoryTags::stats()
+	{
+		std::vector<MemoryTagStats> result;
+		TagRegistry&				registry = get_registry();
+		std::lock_guard				lock(registry.mutex);
+		for (const TaggedHeap* tagged_heap = registry.head; tagged_heap; tagged_heap = tagged_heap->next)
+		{
+			const PagedMemoryPool& heap = tagged_heap->heap;
+			result.push_back({
+				.name = tagged_heap->name,
+				.live_bytes = heap.get_live_bytes(),
+				.peak_live_bytes = heap.get_peak_live_bytes(),
+				.budget = heap.get_budget(),
+				.num_budget_failures = heap.get_num_budget_failures(),
+			});
+		}
+
+		return result;
+	}
+
+	std::string MemoryTags::to_string()
+	{
+		std::string result = std::format("{:<24} {:>14} {:>14} {:>14} {:>10}\n", "tag", "live B", "peak B", "budget B", "failures");
+		for (const MemoryTagStats& tag : stats())
+		{
+			const std::string budget = tag.budget == std::numeric_limits<u64>::max() ? "-" : std::format("{}", tag.budget);
+			result += std::format("{:<24} {:>14} {:>14} {:>14} {:>10}\n", tag.name, tag.live_bytes, tag.peak_live_bytes, budget, tag.num_budget_failures);
+		}
+
+		return result;
+	}
+} // namespace aw::core
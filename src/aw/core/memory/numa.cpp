@@ -0,0 +1,160 @@
+#include "aw/core/memory/numa.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+
+namespace aw::core
+{
+#ifdef __linux__
+	namespace
+	{
+		// From <numaif.h>, which comes with libnuma
+		constexpr int MPOL_PREFERRED = 1;
+
+		// Calls 'fn' for every number in a sysfs list like "0-3,8-11". The topology is read while the allocator may be
+		// initializing, so the file is read without anything that allocates.
+		template <typename Fn>
+		bool for_each_in_list(const char* path, Fn&& fn)
+		{
+			const int file = open(path, O_RDONLY | O_CLOEXEC);
+			if (file < 0)
+				return false;
+
+			char		  buffer[1024];
+			const ssize_t size = read(file, buffer, sizeof(buffer) - 1);
+			close(file);
+			if (size <= 0)
+				return false;
+
+			buffer[size] = '\0';
+			for (const char* cursor = buffer; *cursor >= '0' && *cursor <= '9';)
+			{
+				u32 first = 0;
+				for (; *cursor >= '0' && *cursor <= '9'; ++cursor)
+				{
+					first = first * 10 + (*cursor - '0');
+				}
+
+				u32 last = first;
+				if (*cursor == '-')
+				{
+					last = 0;
+					for (++cursor; *cursor >= '0' && *cursor <= '9'; ++cursor)
+					{
+						last = last * 10 + (*cursor - '0');
+					}
+				}
+
+				for (u32 number = first; number <= last; ++number)
+				{
+					fn(number);
+				}
+
+				if (*cursor == ',')
+					++cursor;
+			}
+
+			return true;
+		}
+	} // namespace
+#endif
+
+	u32 Numa::get_num_nodes()
+	{
+		static const u32 num_nodes = [] {
+			u32 highest_node = 0;
+#ifdef _WIN32
+			ULONG highest = 0;
+			if (GetNumaHighestNodeNumber(&highest))
+				highest_node = highest;
+#elif defined(__linux__)
+			for_each_in_list("/sys/devices/system/node/online", [&highest_node](const u32 node) { highest_node = std::max(highest_node, node); });
+#endif
+			return std::min(highest_node + 1, MAX_NODES);
+		}();
+
+		return num_nodes;
+	}
+
+	u32 Numa::get_current_node()
+	{
+		if (get_num_nodes() == 1)
+			return 0;
+
+#ifdef _WIN32
+		PROCESSOR_NUMBER processor{};
+		GetCurrentProcessorNumberEx(&processor);
+		USHORT node = 0;
+		GetNumaProcessorNodeEx(&processor, &node);
+		return node % MAX_NODES;
+#elif defined(__linux__)
+		// getcpu() goes through the vDSO, so it doesn't enter the kernel. Older glibc versions don't wrap it.
+		unsigned cpu = 0;
+		unsigned node = 0;
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 29)
+		if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+			return 0;
+#else
+		if (getcpu(&cpu, &node) != 0)
+			return 0;
+#endif
+
+		return node % MAX_NODES;
+#else
+		return 0;
+#endif
+	}
+
+	bool Numa::bind(void* address, const u64 size, const u32 node)
+	{
+#ifdef __linux__
+		if (get_num_nodes() == 1)
+			return true;
+
+		const unsigned long node_mask = 1ul << node;
+		return syscall(SYS_mbind, address, size, MPOL_PREFERRED, &node_mask, sizeof(node_mask) * 8, 0) == 0;
+#else
+		(void)address;
+		(void)size;
+		(void)node;
+		return get_num_nodes() == 1;
+#endif
+	}
+
+	bool Numa::run_on_node(const u32 node)
+	{
+#ifdef _WIN32
+		GROUP_AFFINITY affinity{};
+		return GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) && affinity.Mask != 0
+			&& SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+#elif defined(__linux__)
+		char path[64];
+		std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		const bool found = for_each_in_list(path, [&cpus](const u32 cpu) {
+			if (cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &cpus);
+		});
+		if (!found || CPU_COUNT(&cpus) == 0)
+			return false;
+
+		return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+		(void)node;
+		return false;
+#endif
+	}
+} // namespace aw::core
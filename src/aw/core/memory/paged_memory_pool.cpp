@@ -1,157 +1,943 @@
 #include "aw/core/memory/paged_memory_pool.h"
+#include "aw/core/memory/thread_cache.h"
 
+#include "aw/core/memory/heap_profiler.h"
+#include "aw/core/memory/virtual_memory.h"
+
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
 #include <cstring>
 #include <mutex>
+#include <new>
 
 namespace aw::core
 {
-	/**
-	 * TODO: If memory leaks, dump the allocations
-	 */
+	namespace
+	{
+		// Whatever is still sampled when the process exits is most likely a leak
+		struct LeakReport
+		{
+			~LeakReport()
+			{
+				if (HeapProfiler::get_num_live_samples() > 0)
+				{
+					const std::string profile = HeapProfiler::dump();
+					std::fprintf(stderr, "Process exits with live sampled allocations:\n%s", profile.c_str());
+				}
+			}
+		};
 
-	void MemoryPage::alloc_next()
+		void update_peak(std::atomic<u64>& peak, const u64 value)
+		{
+			u64 current = peak.load(std::memory_order::relaxed);
+			while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order::relaxed))
+			{
+			}
+		}
+	} // namespace
+
+	u32 MemoryPage::allocate_blocks(const u64 requested_size, void** out_blocks, const u32 count)
 	{
-		std::lock_guard lock(m_Mutex);
-		if (!m_Next)
+		u32 num_allocated = 0;
+		while (num_allocated < count)
+		{
+			// First, try to allocate from a free list
+			if (const u32 index = m_FreeList.pop(); index != PageFreeList::INVALID_INDEX)
+				out_blocks[num_allocated++] = initialize_block(index, requested_size);
+			// Then try to allocate from the tail
+			else if (m_Tail != m_MaxAllocations && commit_blocks(m_Tail + 1))
+				out_blocks[num_allocated++] = initialize_block(m_Tail++, requested_size);
+			else
+				break;
+		}
+
+		return num_allocated;
+	}
+
+	bool MemoryPage::commit_blocks(const u64 num_blocks)
+	{
+		const u64 required_size = get_blocks_offset() + num_blocks * m_AlignedAllocSize;
+		if (required_size <= m_CommittedSize)
+			return true;
+
+		// Commit a whole step at once, so advancing the tail doesn't end up in the kernel for every block
+		const u64 new_committed_size = std::min<u64>(Math::align_up(required_size, m_CommitStep), DEFAULT_PAGE_SIZE);
+		if (!VirtualMemory::commit(reinterpret_cast<u8*>(this) + m_CommittedSize, new_committed_size - m_CommittedSize))
+			return false;
+
+		m_Tree->m_CommittedBytes.fetch_add(new_committed_size - m_CommittedSize, std::memory_order::relaxed);
+		PagedMemoryPool::on_committed(new_committed_size - m_CommittedSize);
+		m_CommittedSize = new_committed_size;
+		return true;
+	}
+
+	u64 MemoryPage::decommit_blocks()
+	{
+		// Keep the OS pages the page object itself lives in
+		const u64 kept_size = Math::align_up(get_blocks_offset(), VirtualMemory::get_page_size());
+		const u64 decommitted_size = m_CommittedSize > kept_size ? m_CommittedSize - kept_size : 0;
+		if (decommitted_size > 0)
 		{
-			m_Next = static_cast<MemoryPage*>(malloc(sizeof(MemoryPage)));
-			std::construct_at(m_Next, m_AlignedAllocSize);
-			assert(m_Next);
-			m_Next->m_Prev = this;
+			VirtualMemory::decommit(reinterpret_cast<u8*>(this) + kept_size, decommitted_size);
+			m_CommittedSize = kept_size;
+			m_Tree->m_CommittedBytes.fetch_sub(decommitted_size, std::memory_order::relaxed);
+			PagedMemoryPool::on_decommitted(decommitted_size);
 		}
+
+		m_FreeList.clear();
+		m_Tail = 0;
+		return decommitted_size;
 	}
 
-	void MemoryPage::dealloc_next()
+	void* MemoryPage::initialize_block(const u64 index, const u64 requested_size)
 	{
-		std::lock_guard lock(m_Mutex);
-		if (!m_Next)
+		u8* block = get_block_at_index(index);
+		if constexpr (!HEADERLESS_ALLOCATIONS)
+		{
+			reinterpret_cast<AllocationHeader*>(block)->alloc_size = to_u32(requested_size);
+		}
+
+		m_UsageState.fetch_add(1, std::memory_order::acquire);
+		return block + ALLOCATION_HEADER_SIZE;
+	}
+
+	void MemoryPage::free_block(void* block)
+	{
+		if (!block)
 			return;
 
-		MemoryPage* next_next = m_Next->m_Next;
-		std::destroy_at(m_Next);
-		free(m_Next);
-		m_Next = next_next;
+		free_blocks(&block, 1);
 	}
 
-	void* MemoryPage::allocate_block(const u64 requested_size)
+	void MemoryPage::free_blocks(void* const* blocks, const u32 count)
 	{
-		if (m_NumAliveAllocations.load(std::memory_order::acquire) == m_MaxAllocations)
+		u32 index = 0;
+		while (index < count)
 		{
-			std::lock_guard lock(m_Mutex);
-			if (!m_Next)
+			MemoryPage* page = from_allocation(blocks[index]);
+			assert(!page->is_large_allocation());
+
+			// Link the run of blocks that belong to the same page into a chain
+			const u32 first = page->get_block_index(static_cast<u8*>(blocks[index]) - ALLOCATION_HEADER_SIZE);
+			u32		  last = first;
+			u64		  num_freed = 1;
+			for (++index; index < count; ++index)
 			{
-				alloc_next();
+				if (from_allocation(blocks[index]) != page)
+					break;
+
+				const u32 block_index = page->get_block_index(static_cast<u8*>(blocks[index]) - ALLOCATION_HEADER_SIZE);
+				page->m_FreeList.link(last, block_index);
+				last = block_index;
+				++num_freed;
 			}
-			return m_Next->allocate_block(requested_size);
+
+			page->push_free_chain(first, last);
+			page->drop_allocations(num_freed);
 		}
+	}
 
-		std::lock_guard lock(m_Mutex);
-		// First, try to allocate from a free list
-		if (m_FreeList.size > 0)
-			return initialize_header(m_FreeList.pop(), requested_size);
+	u32 MemoryPage::reclaim_blocks(u32& chain, void** out_blocks, const u32 count)
+	{
+		// The free list is only taken once the chain ran dry, so the blocks freed in the meantime pile up and are taken with a single exchange
+		if (chain == PageFreeList::INVALID_INDEX)
+			chain = m_FreeList.take_all();
 
-		// Try to allocate from the tail
-		if (m_Tail != m_MaxAllocations)
+		u32 num_reclaimed = 0;
+		while (num_reclaimed < count && chain != PageFreeList::INVALID_INDEX)
 		{
-			return initialize_header(m_Tail++, requested_size);
+			out_blocks[num_reclaimed++] = get_block_at_index(chain) + ALLOCATION_HEADER_SIZE;
+			chain = m_FreeList.get_next(chain);
 		}
 
-		return nullptr;
+		// The owner keeps the page alive, so the counter can't drop to zero in the meantime
+		if (num_reclaimed > 0)
+		{
+			m_UsageState.fetch_add(num_reclaimed, std::memory_order::relaxed);
+			m_Tree->m_NumReclaimedBlocks.fetch_add(num_reclaimed, std::memory_order::relaxed);
+		}
+
+		return num_reclaimed;
 	}
 
-	void* MemoryPage::initialize_header(const u64 index, const u64 requested_size)
+	void MemoryPage::release_ownership(const u32 chain)
 	{
-		void*	   block = get_block_at_index(index);
-		const auto header = static_cast<AllocationHeader*>(block);
-		header->page = this;
-		header->index = to_u32(index);
-		header->alloc_size = to_u32(requested_size);
-		m_NumAliveAllocations.fetch_add(1, std::memory_order::acquire);
-		return header + 1;
+		if (chain != PageFreeList::INVALID_INDEX)
+		{
+			u32 last = chain;
+			while (m_FreeList.get_next(last) != PageFreeList::INVALID_INDEX)
+			{
+				last = m_FreeList.get_next(last);
+			}
+
+			push_free_chain(chain, last);
+		}
+
+		drop_allocations(1);
 	}
 
-	void MemoryPage::free_block(void* block)
+	void MemoryPage::push_free_chain(const u32 first, const u32 last)
 	{
-		if (!block)
-			return;
+		m_FreeList.push_chain(first, last);
 
-		AllocationHeader* header = static_cast<AllocationHeader*>(block) - 1;
-		// If it is a paged allocation, go through the page-wise deallocation process
-		if (MemoryPage* page = header->page)
+		// Pairs with the fence in PageTree::allocate_blocks. Either the tree sees the pushed blocks before it moves the page to the full list,
+		// or we see that the page is full and move it back.
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+		if (m_Full.load(std::memory_order::relaxed))
 		{
-			std::lock_guard lock(page->m_Mutex);
-			page->m_FreeList.push(header->index);
-			--page->m_NumAliveAllocations;
+			m_Tree->on_full_page_freed(this);
+		}
+	}
 
-			// If the page is not root
-			if constexpr (CLEAR_EMPTY_PAGES)
+	void MemoryPage::drop_allocations(const u64 count)
+	{
+		PageTree* tree = m_Tree;
+
+		// The page can be released as soon as the counter drops to zero, so it must not be touched after this, unless we hold a release check.
+		if constexpr (CLEAR_EMPTY_PAGES)
+		{
+			u64 state = m_UsageState.load(std::memory_order::relaxed);
+			u64 new_state;
+			do
+			{
+				new_state = state - count;
+				if ((new_state & ALIVE_ALLOCATIONS_MASK) == 0)
+					new_state += PENDING_RELEASE_CHECK;
+			}
+			while (!m_UsageState.compare_exchange_weak(state, new_state, std::memory_order::acq_rel, std::memory_order::relaxed));
+
+			if ((new_state & ALIVE_ALLOCATIONS_MASK) == 0)
+			{
+				tree->release_page_if_empty(this);
+			}
+		}
+		else
+		{
+			m_UsageState.fetch_sub(count, std::memory_order::release);
+		}
+	}
+
+	PagedMemoryPool* MemoryPage::get_heap() const
+	{
+		return m_Tree ? m_Tree->get_heap() : m_Heap;
+	}
+
+	u8* MemoryPage::get_block_at_index(const u64 index) const
+	{
+		return get_blocks() + (index * m_AlignedAllocSize);
+	}
+
+	PageTree::~PageTree()
+	{
+		for (PageList* list : { &m_AvailablePages, &m_FullPages, &m_EmptyPages })
+		{
+			while (MemoryPage* page = list->head)
+			{
+				if (list == &m_EmptyPages)
+					PagedMemoryPool::s_RetainedBytes.fetch_sub(page->get_committed_size(), std::memory_order::relaxed);
+
+				list->remove(page);
+				destroy_page(page);
+			}
+		}
+	}
+
+	void* PageTree::allocate_block(const u64 requested_size)
+	{
+		void* block = nullptr;
+		allocate_blocks(requested_size, &block, 1);
+		return block;
+	}
+
+	u32 PageTree::allocate_blocks(const u64 requested_size, void** out_blocks, const u32 count, MemoryPage** owned_page)
+	{
+		u32 num_allocated = 0;
+		u64 num_created_pages = 0;
+		{
+			std::lock_guard lock(m_Mutex);
+			while (num_allocated < count)
 			{
-				if (page->m_NumAliveAllocations.load(std::memory_order::acquire) == 0 && !page->m_Root)
+				MemoryPage* page = m_AvailablePages.head;
+				if (!page)
 				{
-					assert(page->m_Prev);
-					page->m_Prev->dealloc_next();
+					// Reuse a retained empty page before asking the OS for a new one
+					page = m_EmptyPages.head;
+					if (page)
+					{
+						m_EmptyPages.remove(page);
+						m_NumEmptyPages.fetch_sub(1, std::memory_order::relaxed);
+						PagedMemoryPool::s_RetainedBytes.fetch_sub(page->get_committed_size(), std::memory_order::relaxed);
+					}
+					else
+					{
+						page = create_page();
+						if (!page)
+							break;
+
+						++num_created_pages;
+					}
+
+					m_AvailablePages.push_front(page);
+				}
+
+				const u32 num_allocated_from_page = page->allocate_blocks(requested_size, out_blocks + num_allocated, count - num_allocated);
+				num_allocated += num_allocated_from_page;
+
+				// The tail didn't move, because the page couldn't commit more memory
+				if (num_allocated_from_page == 0 && page->m_Tail != page->m_MaxAllocations)
+					break;
+
+				if (page->is_exhausted())
+				{
+					page->m_Full.store(true, std::memory_order::relaxed);
+					std::atomic_thread_fence(std::memory_order::seq_cst);
+
+					// A block could have been freed to the page right before it was marked as full
+					if (page->is_exhausted())
+					{
+						m_AvailablePages.remove(page);
+						m_FullPages.push_front(page);
+					}
+					else
+					{
+						page->m_Full.store(false, std::memory_order::relaxed);
+					}
 				}
 			}
+
+			if (!m_ThreadCached)
+				m_NumAllocations.fetch_add(num_allocated, std::memory_order::relaxed);
+
+			// The last block is live, so the page can't be released before the ownership is counted
+			if (owned_page && num_allocated > 0)
+			{
+				MemoryPage* page = MemoryPage::from_allocation(out_blocks[num_allocated - 1]);
+				page->m_UsageState.fetch_add(1, std::memory_order::relaxed);
+				*owned_page = page;
+			}
 		}
-		// Otherwise clear the block
-		else
+
+		report_new_pages(num_created_pages);
+
+		return num_allocated;
+	}
+
+	MemoryPage* PageTree::create_page()
+	{
+		void* memory = VirtualMemory::reserve(DEFAULT_PAGE_SIZE, DEFAULT_PAGE_SIZE);
+		if (!memory)
+			return nullptr;
+
+		// The policy is set before anything is committed, so the pages are placed on the node no matter which thread touches them first
+		if (PagedMemoryPool::is_numa_aware())
+			Numa::bind(memory, DEFAULT_PAGE_SIZE, m_Node);
+
+		const bool	huge_pages = PagedMemoryPool::are_huge_pages_enabled();
+		const Bytes commit_step = huge_pages ? MemoryPage::HUGE_PAGE_COMMIT_STEP : MemoryPage::COMMIT_STEP;
+		if (huge_pages)
+			VirtualMemory::advise_huge_pages(memory, DEFAULT_PAGE_SIZE);
+
+		// Only the page itself and the first blocks are committed up front
+		if (!VirtualMemory::commit(memory, commit_step))
+		{
+			VirtualMemory::release(memory, DEFAULT_PAGE_SIZE);
+			return nullptr;
+		}
+
+		const auto page = static_cast<MemoryPage*>(memory);
+		std::construct_at(page, this, m_BlockSize, commit_step, commit_step);
+		m_NumPages.fetch_add(1, std::memory_order::relaxed);
+		m_CommittedBytes.fetch_add(commit_step, std::memory_order::relaxed);
+		PagedMemoryPool::on_committed(commit_step);
+		return page;
+	}
+
+	void PageTree::destroy_page(MemoryPage* page)
+	{
+		page->m_Tree->m_NumPages.fetch_sub(1, std::memory_order::relaxed);
+		page->m_Tree->m_CommittedBytes.fetch_sub(page->get_committed_size(), std::memory_order::relaxed);
+		PagedMemoryPool::on_decommitted(page->get_committed_size());
+		std::destroy_at(page);
+		VirtualMemory::release(page, DEFAULT_PAGE_SIZE);
+	}
+
+	void PageTree::report_new_pages(const u64 num_pages) const
+	{
+		for (u64 index = 0; index < num_pages; ++index)
 		{
-			free(header);
+			PagedMemoryPool::report_growth({
+				.kind = PoolGrowthEvent::Kind::Page,
+				.heap = m_Heap,
+				.size_class_index = m_SizeClassIndex,
+				.node = m_Node,
+				.size = DEFAULT_PAGE_SIZE.value,
+			});
 		}
 	}
 
-	void* MemoryPage::get_block_at_index(const u64 index)
+	u64 PageTree::reserve(const u64 num_blocks)
 	{
-		return m_Memory.data() + (index * m_AlignedAllocSize);
+		u64 num_created_pages = 0;
+		{
+			std::lock_guard lock(m_Mutex);
+			u64				num_free_blocks = 0;
+			for (const PageList* list : { &m_AvailablePages, &m_EmptyPages })
+			{
+				for (const MemoryPage* page = list->head; page; page = page->m_Next)
+				{
+					num_free_blocks += page->get_max_allocations() - std::min(page->get_num_alive_allocations(), page->get_max_allocations());
+				}
+			}
+
+			while (num_free_blocks < num_blocks)
+			{
+				MemoryPage* page = create_page();
+				if (!page)
+					break;
+
+				// Only the blocks that are asked for are committed, the rest of the last page is committed as usual once it's reached
+				const u64 num_page_blocks = std::min(num_blocks - num_free_blocks, page->get_max_allocations());
+				if (page->commit_blocks(num_page_blocks))
+					VirtualMemory::prefault(page, page->get_committed_size());
+
+				m_AvailablePages.push_front(page);
+				num_free_blocks += page->get_max_allocations();
+				++num_created_pages;
+			}
+		}
+
+		report_new_pages(num_created_pages);
+		return num_created_pages;
 	}
 
-	void MemoryPage::shutdown()
+	void PageTree::on_full_page_freed(MemoryPage* page)
 	{
-		// assert_msg(m_num_alive_allocations == 0, "It seems like there is a memory leak.");
-		if (m_Next)
+		std::lock_guard lock(m_Mutex);
+		if (page->m_Full.load(std::memory_order::relaxed))
 		{
-			m_Next->shutdown();
-			dealloc_next();
+			page->m_Full.store(false, std::memory_order::relaxed);
+			m_FullPages.remove(page);
+			m_AvailablePages.push_front(page);
 		}
 	}
 
+	void PageTree::release_page_if_empty(MemoryPage* page)
+	{
+		std::lock_guard lock(m_Mutex);
+		const u64		state = page->m_UsageState.fetch_sub(MemoryPage::PENDING_RELEASE_CHECK, std::memory_order::acq_rel) - MemoryPage::PENDING_RELEASE_CHECK;
+
+		if (state != 0)
+			return;
+
+		(page->m_Full.load(std::memory_order::relaxed) ? m_FullPages : m_AvailablePages).remove(page);
+		page->m_Full.store(false, std::memory_order::relaxed);
+
+		// Keep the page around while the retention limits allow it, so a workload that keeps crossing a page boundary doesn't create
+		// and release a page every time.
+		bool retain = m_NumEmptyPages.load(std::memory_order::relaxed) < PagedMemoryPool::get_max_empty_pages_per_class();
+		if (retain)
+		{
+			// The budget is shared by all trees, so reserve the bytes first and give them back if they don't fit
+			const u64 committed_size = page->get_committed_size();
+			if (PagedMemoryPool::s_RetainedBytes.fetch_add(committed_size, std::memory_order::relaxed) + committed_size > PagedMemoryPool::get_max_retained_bytes())
+			{
+				PagedMemoryPool::s_RetainedBytes.fetch_sub(committed_size, std::memory_order::relaxed);
+				retain = false;
+			}
+		}
+
+		if (retain)
+		{
+			m_EmptyPages.push_front(page);
+			m_NumEmptyPages.fetch_add(1, std::memory_order::relaxed);
+			return;
+		}
+
+		destroy_page(page);
+	}
+
+	u64 PageTree::trim()
+	{
+		std::lock_guard lock(m_Mutex);
+		u64				decommitted_size = 0;
+		for (MemoryPage* page = m_EmptyPages.head; page; page = page->m_Next)
+		{
+			decommitted_size += page->decommit_blocks();
+		}
+
+		PagedMemoryPool::s_RetainedBytes.fetch_sub(decommitted_size, std::memory_order::relaxed);
+		return decommitted_size;
+	}
+
+	void PageTree::PageList::push_front(MemoryPage* page)
+	{
+		page->m_Prev = nullptr;
+		page->m_Next = head;
+		if (head)
+			head->m_Prev = page;
+		head = page;
+	}
+
+	void PageTree::PageList::remove(MemoryPage* page)
+	{
+		if (page->m_Prev)
+			page->m_Prev->m_Next = page->m_Next;
+		else
+			head = page->m_Next;
+
+		if (page->m_Next)
+			page->m_Next->m_Prev = page->m_Prev;
+
+		page->m_Prev = nullptr;
+		page->m_Next = nullptr;
+	}
+
 	void* PagedMemoryPool::allocate_memory(const Bytes size)
 	{
 		if (size == 0)
 			return nullptr;
 
-		// If the size is bigger than the page, allocate it just using malloc
-		if (size > DEFAULT_PAGE_SIZE)
+		// If the block doesn't fit into the page, give it a chunk of its own
+		if (!is_paged_allocation_size(size))
+		{
+			return allocate_large(size);
+		}
+
+		const u64 size_class_index = get_size_class_index(size);
+		if (!charge(SizeClasses::get_block_size(size_class_index)))
+			return nullptr;
+
+		ThreadCache* cache = m_ThreadCached && ThreadCache::is_class_cached(size_class_index) ? ThreadCache::get() : nullptr;
+		void*		 memory = cache ? cache->allocate(*this, size_class_index, size) : get_page_tree(size_class_index)->allocate_block(size);
+		if (!memory)
 		{
-			const auto header = static_cast<AllocationHeader*>(malloc(size + sizeof(AllocationHeader)));
-			assert(header);
-			std::construct_at(header);
-			header->page = nullptr;
-			header->index = std::numeric_limits<u32>::max();
-			header->alloc_size = to_u32(size.value);
-			return header + 1;
+			uncharge(SizeClasses::get_block_size(size_class_index));
+			return nullptr;
 		}
 
-		MemoryPage* tree_root = get_page_tree_for_allocation(size);
-		return tree_root->allocate_block(size);
+		// Trees of the other heaps count their allocations themselves
+		if (m_ThreadCached)
+			ThreadAllocationCounters::record_allocation(size_class_index);
+		if (HeapProfiler::should_sample(size)) [[unlikely]]
+		{
+			// Keyed by the block, aligned allocations move the pointer inside of it
+			MemoryPage::from_allocation(memory)->m_NumSamples.fetch_add(1, std::memory_order::relaxed);
+			HeapProfiler::record_allocation(static_cast<u8*>(memory) - ALLOCATION_HEADER_SIZE, size);
+		}
+
+		return memory;
 	}
 
 	void PagedMemoryPool::free_memory(void* memory)
 	{
+		if (!memory)
+			return;
+
+		MemoryPage* page = MemoryPage::from_allocation(memory);
+		if (page->is_large_allocation())
+		{
+			free_large(page);
+			return;
+		}
+
+		free_paged(memory, page, page->get_tree()->get_size_class_index());
+	}
+
+	void PagedMemoryPool::free_memory(void* memory, const Bytes size)
+	{
+		if (!memory)
+			return;
+
+		MemoryPage* page = MemoryPage::from_allocation(memory);
+		if (!is_paged_allocation_size(size))
+		{
+			free_large(page);
+			return;
+		}
+
+		const u64 size_class_index = get_size_class_index(size);
+		assert(!page->is_large_allocation() && page->get_tree()->get_size_class_index() == size_class_index);
+		free_paged(memory, page, size_class_index);
+	}
+
+	void PagedMemoryPool::free_paged(void* memory, MemoryPage* page, const u64 size_class_index)
+	{
+		if (page->m_NumSamples.load(std::memory_order::relaxed) != 0) [[unlikely]]
+		{
+			const u8* block = page->get_block_at_index(page->get_block_index(static_cast<u8*>(memory) - ALLOCATION_HEADER_SIZE));
+			if (HeapProfiler::record_free(block))
+				page->m_NumSamples.fetch_sub(1, std::memory_order::relaxed);
+		}
+
+		PageTree* tree = page->get_tree();
+		if (!tree->is_thread_cached())
+		{
+			tree->m_NumFrees.fetch_add(1, std::memory_order::relaxed);
+			tree->get_heap()->uncharge(tree->get_block_size());
+			MemoryPage::free_block(memory);
+			return;
+		}
+
+		ThreadAllocationCounters::record_free(size_class_index);
+		if (ThreadCache::is_class_cached(size_class_index))
+		{
+			if (ThreadCache* cache = ThreadCache::get())
+			{
+				// An aligned allocation points into its block, but the cache hands the block out again as a regular one
+				const u32 index = page->get_block_index(static_cast<u8*>(memory) - ALLOCATION_HEADER_SIZE);
+				cache->deallocate(page->get_block_at_index(index) + ALLOCATION_HEADER_SIZE, size_class_index);
+				return;
+			}
+		}
+
 		MemoryPage::free_block(memory);
 	}
 
-	MemoryPage* PagedMemoryPool::get_page_tree_for_allocation(const Bytes allocation_size)
+	void* PagedMemoryPool::reallocate_memory(void* memory, const Bytes new_size)
+	{
+		if (!memory)
+			return allocate_memory(new_size);
+
+		if (new_size == 0)
+		{
+			free_memory(memory);
+			return nullptr;
+		}
+
+		MemoryPage* page = MemoryPage::from_allocation(memory);
+		if (page->is_large_allocation())
+		{
+			if (void* resized = resize_large(page, memory, new_size))
+				return resized;
+		}
+		else if (is_paged_allocation_size(new_size) && get_size_class_index(new_size) == page->get_tree()->get_size_class_index())
+		{
+			// Aligned allocations sit further inside their block, so they may still not fit
+			const u8* block = page->get_block_at_index(page->get_block_index(static_cast<u8*>(memory) - ALLOCATION_HEADER_SIZE));
+			if (static_cast<u8*>(memory) + new_size <= block + page->get_block_size())
+			{
+				if constexpr (!HEADERLESS_ALLOCATIONS)
+				{
+					(static_cast<AllocationHeader*>(memory) - 1)->alloc_size = to_u32(new_size.value);
+				}
+
+				return memory;
+			}
+		}
+
+		void* moved = page->get_heap()->allocate_memory(new_size);
+		if (!moved)
+			return nullptr;
+
+		// The whole usable size may have been written to, not only the size that was asked for
+		std::memcpy(moved, memory, std::min<u64>(get_usable_size(memory), new_size));
+		free_memory(memory);
+		return moved;
+	}
+
+	void* PagedMemoryPool::allocate_memory_aligned(const Bytes size, const u64 alignment)
+	{
+		assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+		if (alignment <= MIN_ALIGNMENT)
+			return allocate_memory(size);
+
+		if (size == 0 || alignment > MAX_ALIGNMENT)
+			return nullptr;
+
+		if constexpr (HEADERLESS_ALLOCATIONS)
+		{
+			// Blocks start at multiples of their size from a 64-byte aligned offset, so the block may be aligned enough already
+			if (alignment <= 64 && is_paged_allocation_size(size) && SizeClasses::get_block_size(get_size_class_index(size)) % alignment == 0)
+				return allocate_memory(size);
+		}
+
+		// Take a block that is big enough to fit the allocation at any aligned address inside of it
+		const Bytes padded_size = size + alignment - MIN_ALIGNMENT;
+		if (alignment > MAX_PAGED_ALIGNMENT || !is_paged_allocation_size(padded_size))
+			return allocate_large(size, alignment);
+
+		u8* memory = static_cast<u8*>(allocate_memory(padded_size));
+		if (!memory)
+			return nullptr;
+
+		u8* aligned_memory = memory + (Math::align_up(reinterpret_cast<std::uintptr_t>(memory), alignment) - reinterpret_cast<std::uintptr_t>(memory));
+		if constexpr (!HEADERLESS_ALLOCATIONS)
+		{
+			// The header moves along, it always sits right in front of the memory
+			(reinterpret_cast<AllocationHeader*>(aligned_memory) - 1)->alloc_size = to_u32(size.value);
+		}
+
+		return aligned_memory;
+	}
+
+	void* PagedMemoryPool::allocate_large(const Bytes size, const u64 alignment)
+	{
+		const u64 memory_offset = Math::align_up(MemoryPage::get_blocks_offset(), alignment);
+		const u64 used_size = memory_offset + size;
+		if (!charge(used_size - MemoryPage::get_blocks_offset()))
+			return nullptr;
+
+		MemoryPage* page = BuddyAllocator::fits(used_size) ? s_BuddyAllocator.allocate(used_size) : allocate_chunk(used_size);
+		if (!page)
+		{
+			uncharge(used_size - MemoryPage::get_blocks_offset());
+			return nullptr;
+		}
+
+		page->m_Heap = this;
+		{
+			std::lock_guard lock(m_LargeAllocationsMutex);
+			page->m_Next = m_LargeAllocations;
+			if (m_LargeAllocations)
+				m_LargeAllocations->m_Prev = page;
+
+			m_LargeAllocations = page;
+		}
+
+		s_LiveLargeAllocations.fetch_add(1, std::memory_order::relaxed);
+		s_TotalLargeAllocations.fetch_add(1, std::memory_order::relaxed);
+		const u64 block_size = page->get_block_size();
+		update_peak(s_PeakLargeAllocationBytes, s_LargeAllocationBytes.fetch_add(block_size, std::memory_order::relaxed) + block_size);
+
+		if (!BuddyAllocator::fits(used_size))
+			report_growth({ .kind = PoolGrowthEvent::Kind::LargeChunk, .heap = this, .size = page->get_chunk_size() });
+
+		if (HeapProfiler::should_sample(size)) [[unlikely]]
+		{
+			page->m_NumSamples.store(1, std::memory_order::relaxed);
+			HeapProfiler::record_allocation(page, size);
+		}
+
+		return reinterpret_cast<u8*>(page) + memory_offset;
+	}
+
+	MemoryPage* PagedMemoryPool::allocate_chunk(const u64 used_size)
+	{
+		const u64 chunk_size = Math::align_up(used_size, DEFAULT_PAGE_SIZE);
+		void*	  memory = VirtualMemory::reserve(chunk_size, DEFAULT_PAGE_SIZE);
+		if (!memory)
+			return nullptr;
+
+		if (are_huge_pages_enabled())
+			VirtualMemory::advise_huge_pages(memory, chunk_size);
+
+		const u64 committed_size = Math::align_up(used_size, VirtualMemory::get_page_size());
+		if (!VirtualMemory::commit(memory, committed_size))
+		{
+			VirtualMemory::release(memory, chunk_size);
+			return nullptr;
+		}
+
+		on_committed(committed_size);
+		return std::construct_at(static_cast<MemoryPage*>(memory), nullptr, used_size - MemoryPage::get_blocks_offset(), committed_size);
+	}
+
+	MemoryPage* PagedMemoryPool::remap_chunk(MemoryPage* page, const u64 used_size)
+	{
+		// The key of the sample is the address of the page
+		if (page->m_NumSamples.load(std::memory_order::relaxed) != 0)
+			return nullptr;
+
+		const u64 chunk_size = Math::align_up(used_size, DEFAULT_PAGE_SIZE);
+		void*	  memory = VirtualMemory::reserve(chunk_size, DEFAULT_PAGE_SIZE);
+		if (!memory)
+			return nullptr;
+
+		if (are_huge_pages_enabled())
+			VirtualMemory::advise_huge_pages(memory, chunk_size);
+
+		// Commit the new part first, nothing can fail anymore once the pages are moved
+		const u64 old_chunk_size = page->get_chunk_size();
+		const u64 committed_size = page->get_committed_size();
+		const u64 new_committed_size = Math::align_up(used_size, VirtualMemory::get_page_size());
+		if (new_committed_size > committed_size && !VirtualMemory::commit(static_cast<u8*>(memory) + committed_size, new_committed_size - committed_size))
+		{
+			VirtualMemory::release(memory, chunk_size);
+			return nullptr;
+		}
+
+		// The neighbours in the list of the heap point to the page, so they must not be unlinked while it moves
+		PagedMemoryPool* heap = page->m_Heap;
+		std::lock_guard	 lock(heap->m_LargeAllocationsMutex);
+		if (!VirtualMemory::remap(page, std::min(committed_size, new_committed_size), memory))
+		{
+			VirtualMemory::release(memory, chunk_size);
+			return nullptr;
+		}
+
+		// Pages of a shrinking chunk that weren't moved go away with the old reservation
+		VirtualMemory::release(page, old_chunk_size);
+		if (new_committed_size > committed_size)
+			on_committed(new_committed_size - committed_size);
+		else
+			on_decommitted(committed_size - new_committed_size);
+
+		const auto new_page = static_cast<MemoryPage*>(memory);
+		new_page->m_CommittedSize = new_committed_size;
+		(new_page->m_Prev ? new_page->m_Prev->m_Next : heap->m_LargeAllocations) = new_page;
+		if (new_page->m_Next)
+			new_page->m_Next->m_Prev = new_page;
+
+		return new_page;
+	}
+
+	void* PagedMemoryPool::resize_large(MemoryPage* page, void* memory, const Bytes new_size)
+	{
+		// Allocations that shrink into another tier are copied, so they don't hold on to the chunk
+		const u64 memory_offset = static_cast<u8*>(memory) - reinterpret_cast<u8*>(page);
+		const u64 used_size = memory_offset + new_size;
+		if (is_paged_allocation_size(new_size))
+			return nullptr;
+
+		// Growing counts against the budget before the chunk takes any memory
+		PagedMemoryPool* heap = page->m_Heap;
+		const u64		 old_block_size = page->get_block_size();
+		const u64		 new_block_size = used_size - MemoryPage::get_blocks_offset();
+		const u64		 grown_size = new_block_size > old_block_size ? new_block_size - old_block_size : 0;
+		if (!heap->charge(grown_size))
+			return nullptr;
+
+		page = resize_chunk(page, used_size);
+		if (!page)
+		{
+			heap->uncharge(grown_size);
+			return nullptr;
+		}
+
+		page->m_AlignedAllocSize = new_block_size;
+		if (new_block_size > old_block_size)
+		{
+			update_peak(s_PeakLargeAllocationBytes, s_LargeAllocationBytes.fetch_add(grown_size, std::memory_order::relaxed) + grown_size);
+		}
+		else
+		{
+			s_LargeAllocationBytes.fetch_sub(old_block_size - new_block_size, std::memory_order::relaxed);
+			heap->uncharge(old_block_size - new_block_size);
+		}
+
+		return reinterpret_cast<u8*>(page) + memory_offset;
+	}
+
+	MemoryPage* PagedMemoryPool::resize_chunk(MemoryPage* page, const u64 used_size)
+	{
+		if (page->is_buddy_block())
+			return BuddyAllocator::get_block_size(used_size) == page->get_chunk_size() && s_BuddyAllocator.commit(page, used_size) ? page : nullptr;
+
+		if (BuddyAllocator::fits(used_size))
+			return nullptr;
+
+		// The size of the reservation follows from the size of the allocation, so it has to move when that changes
+		if (Math::align_up(used_size, DEFAULT_PAGE_SIZE) != page->get_chunk_size())
+			return remap_chunk(page, used_size);
+
+		const u64 committed_size = page->get_committed_size();
+		const u64 required_size = Math::align_up(used_size, VirtualMemory::get_page_size());
+		if (required_size > committed_size)
+		{
+			if (!VirtualMemory::commit(reinterpret_cast<u8*>(page) + committed_size, required_size - committed_size))
+				return nullptr;
+
+			on_committed(required_size - committed_size);
+			page->m_CommittedSize = required_size;
+		}
+		else if (required_size < committed_size)
+		{
+			VirtualMemory::decommit(reinterpret_cast<u8*>(page) + required_size, committed_size - required_size);
+			on_decommitted(committed_size - required_size);
+			page->m_CommittedSize = required_size;
+		}
+
+		return page;
+	}
+
+	void PagedMemoryPool::free_large(MemoryPage* page)
+	{
+		if (page->m_NumSamples.load(std::memory_order::relaxed) != 0) [[unlikely]]
+			HeapProfiler::record_free(page);
+
+		{
+			PagedMemoryPool* heap = page->m_Heap;
+			std::lock_guard	 lock(heap->m_LargeAllocationsMutex);
+			(page->m_Prev ? page->m_Prev->m_Next : heap->m_LargeAllocations) = page->m_Next;
+			if (page->m_Next)
+				page->m_Next->m_Prev = page->m_Prev;
+
+			page->m_Prev = nullptr;
+			page->m_Next = nullptr;
+			heap->uncharge(page->get_block_size());
+		}
+
+		s_LiveLargeAllocations.fetch_sub(1, std::memory_order::relaxed);
+		s_LargeAllocationBytes.fetch_sub(page->get_block_size(), std::memory_order::relaxed);
+		if (page->is_buddy_block())
+		{
+			s_BuddyAllocator.free(page);
+			return;
+		}
+
+		const u64 chunk_size = page->get_chunk_size();
+		on_decommitted(page->get_committed_size());
+		std::destroy_at(page);
+		VirtualMemory::release(page, chunk_size);
+	}
+
+	void PagedMemoryPool::set_budget(const Bytes max_live_bytes, const PoolBudgetHook hook)
+	{
+		m_BudgetHook.store(hook, std::memory_order::release);
+		m_Budget.store(max_live_bytes, std::memory_order::relaxed);
+	}
+
+	bool PagedMemoryPool::charge_tracked(const u64 bytes)
+	{
+		const u64 live_bytes = m_LiveBytes.fetch_add(bytes, std::memory_order::relaxed) + bytes;
+		if (live_bytes > m_Budget.load(std::memory_order::relaxed)) [[unlikely]]
+		{
+			const PoolBudgetHook hook = m_BudgetHook.load(std::memory_order::acquire);
+			if (!hook || !hook(*this, bytes))
+			{
+				m_LiveBytes.fetch_sub(bytes, std::memory_order::relaxed);
+				m_NumBudgetFailures.fetch_add(1, std::memory_order::relaxed);
+				return false;
+			}
+		}
+
+		update_peak(m_PeakLiveBytes, live_bytes);
+		return true;
+	}
+
+	void PagedMemoryPool::set_thread_cache_depth(const u32 depth)
+	{
+		ThreadCache::set_depth(depth);
+	}
+
+	u32 PagedMemoryPool::get_thread_cache_depth()
+	{
+		return ThreadCache::get_depth();
+	}
+
+	void PagedMemoryPool::flush_thread_cache()
 	{
-		// Check if the allocation size is more than DEFAULT_PAGE_SIZE.
+		if (ThreadCache* cache = ThreadCache::get())
+		{
+			cache->flush();
+		}
+	}
+
+	PageTree* PagedMemoryPool::get_page_tree(const u64 size_class_index)
+	{
+		return get_page_tree(size_class_index, is_numa_aware() ? Numa::get_current_node() : 0);
+	}
+
+	PageTree* PagedMemoryPool::get_page_tree(const u64 size_class_index, const u32 node)
+	{
+		// Check if the block is too big for a page.
 		// We shouldn't get here if everything is correct
-		assert(allocation_size <= DEFAULT_PAGE_SIZE);
+		assert(size_class_index <= MAX_PAGED_SIZE_CLASS_INDEX);
 
-		const Bytes aligned_size = Math::align_to_pow2(allocation_size + sizeof(AllocationHeader));
-		const u64	page_index = Math::fast_log2(aligned_size);
 		// Check if a page tree at the index exists, if not, create it
-		MemoryPage*&	 found_page_tree = m_PageTrees.at(page_index);
+		PageTree*&		 found_page_tree = m_PageTrees.at(node % Numa::MAX_NODES).at(size_class_index);
 		std::shared_lock read_lock(m_PageTreesMutex);
 		if (found_page_tree)
 		{
@@ -162,31 +948,133 @@ namespace aw::core
 		std::unique_lock write_lock(m_PageTreesMutex);
 		if (!found_page_tree)
 		{
-			found_page_tree = static_cast<MemoryPage*>(malloc(sizeof(MemoryPage)));
-			std::construct_at(found_page_tree, aligned_size);
-			found_page_tree->set_root();
+			found_page_tree = static_cast<PageTree*>(malloc(sizeof(PageTree)));
+			std::construct_at(found_page_tree, this, size_class_index, node % Numa::MAX_NODES, m_ThreadCached);
 		}
 
 		return found_page_tree;
 	}
 
+	u64 PagedMemoryPool::reserve(const u64 size_class_index, const u64 num_blocks)
+	{
+		return get_page_tree(size_class_index)->reserve(num_blocks);
+	}
+
+	u64 PagedMemoryPool::reserve(const Bytes bytes_per_class)
+	{
+		u64 num_created_pages = 0;
+		for (u64 size_class_index = 0; size_class_index <= MAX_PAGED_SIZE_CLASS_INDEX; ++size_class_index)
+		{
+			const u64 block_size = SizeClasses::get_block_size(size_class_index);
+			num_created_pages += reserve(size_class_index, (bytes_per_class.value + block_size - 1) / block_size);
+		}
+
+		return num_created_pages;
+	}
+
+	u64 PagedMemoryPool::trim()
+	{
+		u64				 trimmed_size = 0;
+		std::shared_lock lock(m_PageTreesMutex);
+		for (const auto& node_trees : m_PageTrees)
+		{
+			for (PageTree* tree : node_trees)
+			{
+				if (tree)
+					trimmed_size += tree->trim();
+			}
+		}
+
+		return trimmed_size + s_BuddyAllocator.trim();
+	}
+
+	PoolStats PagedMemoryPool::stats()
+	{
+		PoolStats stats{};
+		if (m_ThreadCached)
+			ThreadAllocationCounters::collect(stats);
+
+		{
+			std::shared_lock lock(m_PageTreesMutex);
+			for (u64 index = 0; index < SizeClasses::NUM_CLASSES; ++index)
+			{
+				SizeClassStats& size_class = stats.size_classes[index];
+				size_class.block_size = SizeClasses::get_block_size(index);
+				u64 num_frees = 0;
+				for (const auto& node_trees : m_PageTrees)
+				{
+					if (const PageTree* tree = node_trees[index])
+					{
+						size_class.num_pages += tree->get_num_pages();
+						size_class.num_empty_pages += tree->get_num_empty_pages();
+						size_class.committed_bytes += tree->get_committed_bytes();
+						size_class.reclaimed_blocks += tree->get_num_reclaimed_blocks();
+						if (!m_ThreadCached)
+						{
+							size_class.total_allocations += tree->get_num_allocations();
+							num_frees += tree->get_num_frees();
+						}
+					}
+				}
+
+				if (!m_ThreadCached)
+					size_class.live_blocks = size_class.total_allocations > num_frees ? size_class.total_allocations - num_frees : 0;
+
+				size_class.used_bytes = size_class.live_blocks * size_class.block_size;
+				stats.used_bytes += size_class.used_bytes;
+			}
+		}
+
+		stats.committed_bytes = s_CommittedBytes.load(std::memory_order::relaxed);
+		stats.peak_committed_bytes = s_PeakCommittedBytes.load(std::memory_order::relaxed);
+		stats.retained_bytes = s_RetainedBytes.load(std::memory_order::relaxed);
+		stats.live_large_allocations = s_LiveLargeAllocations.load(std::memory_order::relaxed);
+		stats.total_large_allocations = s_TotalLargeAllocations.load(std::memory_order::relaxed);
+		stats.large_allocation_bytes = s_LargeAllocationBytes.load(std::memory_order::relaxed);
+		stats.peak_large_allocation_bytes = s_PeakLargeAllocationBytes.load(std::memory_order::relaxed);
+		stats.used_bytes += stats.large_allocation_bytes;
+		stats.buddy = s_BuddyAllocator.stats();
+		return stats;
+	}
+
+	void PagedMemoryPool::on_committed(const u64 size)
+	{
+		update_peak(s_PeakCommittedBytes, s_CommittedBytes.fetch_add(size, std::memory_order::relaxed) + size);
+	}
+
+	void PagedMemoryPool::on_decommitted(const u64 size)
+	{
+		s_CommittedBytes.fetch_sub(size, std::memory_order::relaxed);
+	}
+
 	PagedMemoryPool::~PagedMemoryPool()
 	{
-		for (const auto& page : m_PageTrees)
+		for (const auto& node_trees : m_PageTrees)
 		{
-			if (page)
+			for (PageTree* tree : node_trees)
 			{
-				page->shutdown();
-				std::destroy_at(page);
-				free(page);
+				if (tree)
+				{
+					std::destroy_at(tree);
+					free(tree);
+				}
 			}
 		}
+
+		while (MemoryPage* page = m_LargeAllocations)
+		{
+			free_large(page);
+		}
 	}
 
 	PagedMemoryPool& PagedMemoryPool::get()
 	{
-		static PagedMemoryPool instance;
-		return instance;
+		// Never destroyed. Objects that outlive it in the static destruction order still free into it, and so does the runtime itself
+		// when the global operator new is replaced. The pages go back to the OS with the process.
+		alignas(PagedMemoryPool) static std::byte storage[sizeof(PagedMemoryPool)];
+		static PagedMemoryPool*				   instance = ::new (static_cast<void*>(storage)) PagedMemoryPool(true);
+		static LeakReport					   leak_report;
+		return *instance;
 	}
 
 	u64 PagedMemoryPool::get_allocation_size(const void* const data)
@@ -196,61 +1084,104 @@ namespace aw::core
 			return 0;
 		}
 
-		const AllocationHeader* header = static_cast<const AllocationHeader*>(data) - 1;
-		return header->alloc_size;
-	}
+		const MemoryPage* page = MemoryPage::from_allocation(data);
+		if (page->is_large_allocation())
+		{
+			// The allocation reaches to the end of the only block
+			return page->get_blocks() + page->get_block_size() - static_cast<const u8*>(data);
+		}
 
-	PageFreeList::PageFreeList(const u32 preallocated_capacity /*= {}*/)
-		: capacity(preallocated_capacity)
-	{
-		if (preallocated_capacity > 0)
+		if constexpr (HEADERLESS_ALLOCATIONS)
 		{
-			data = static_cast<u32*>(malloc(sizeof(u32) * capacity));
+			// The rest of the block. Aligned allocations don't start at the beginning of it.
+			const u8* block = page->get_block_at_index(page->get_block_index(data));
+			return block + page->get_block_size() - static_cast<const u8*>(data);
 		}
+		else
+		{
+			return (static_cast<const AllocationHeader*>(data) - 1)->alloc_size;
+		}
+	}
+
+	u64 PagedMemoryPool::get_usable_size(const void* data)
+	{
+		if (!data)
+			return 0;
+
+		// Large allocations can be written up to the end of their committed memory
+		const MemoryPage* page = MemoryPage::from_allocation(data);
+		if (page->is_large_allocation())
+			return reinterpret_cast<const u8*>(page) + page->get_committed_size() - static_cast<const u8*>(data);
+
+		const u8* block = page->get_block_at_index(page->get_block_index(static_cast<const u8*>(data) - ALLOCATION_HEADER_SIZE));
+		return block + page->get_block_size() - static_cast<const u8*>(data);
 	}
 
-	PageFreeList::~PageFreeList()
+	PageFreeList::PageFreeList(u8* blocks, const u64 block_stride)
+		: m_Blocks(blocks)
+		, m_BlockStride(block_stride)
 	{
-		if (data)
-			free(data);
+	}
+
+	void PageFreeList::clear()
+	{
+		m_Head.store(make_head(get_head_tag(m_Head.load(std::memory_order::relaxed)) + 1, INVALID_INDEX), std::memory_order::relaxed);
 	}
 
 	void PageFreeList::push(const u32 index)
 	{
-		std::lock_guard lock(m_Mutex);
-		if (tail == capacity)
+		push_chain(index, index);
+	}
+
+	void PageFreeList::link(const u32 index, const u32 next)
+	{
+		get_link(index).store(next, std::memory_order::relaxed);
+	}
+
+	void PageFreeList::push_chain(const u32 first, const u32 last)
+	{
+		u64 head = m_Head.load(std::memory_order::relaxed);
+		do
 		{
-			const u64 old_capacity = capacity;
-			capacity = to_u32(CAPACITY_INCREMENT * capacity);
-			const auto new_block = static_cast<u32*>(malloc(capacity * sizeof(u32)));
-			assert(new_block);
-			std::memcpy(new_block, data, old_capacity * sizeof(u32));
-			free(data);
-			data = new_block;
+			link(last, get_head_index(head));
 		}
-
-		data[tail++] = index;
-		++size;
+		while (!m_Head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, first), std::memory_order::release, std::memory_order::relaxed));
 	}
 
 	u32 PageFreeList::peek() const
 	{
-		if (size == 0)
-			return std::numeric_limits<u32>::max();
+		return get_head_index(m_Head.load(std::memory_order::acquire));
+	}
 
-		return data[tail - 1];
+	u32 PageFreeList::take_all()
+	{
+		u64 head = m_Head.load(std::memory_order::relaxed);
+		while (get_head_index(head) != INVALID_INDEX
+			&& !m_Head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, INVALID_INDEX), std::memory_order::acquire, std::memory_order::relaxed))
+		{
+		}
+
+		return get_head_index(head);
 	}
 
 	u32 PageFreeList::pop()
 	{
-		std::lock_guard lock(m_Mutex);
-		if (size == 0)
-			return std::numeric_limits<u32>::max();
+		u64 head = m_Head.load(std::memory_order::acquire);
+		while (get_head_index(head) != INVALID_INDEX)
+		{
+			// If the block was popped and reused in the meantime, the link is garbage, but the tag makes the CAS fail.
+			const u32 next = get_link(get_head_index(head)).load(std::memory_order::relaxed);
+			if (m_Head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, next), std::memory_order::acquire, std::memory_order::acquire))
+			{
+				return get_head_index(head);
+			}
+		}
 
-		const u32 value = peek();
-		--tail;
-		--size;
+		return INVALID_INDEX;
+	}
 
-		return value;
+	std::atomic_ref<u32> PageFreeList::get_link(const u32 index) const
+	{
+		return std::atomic_ref(*reinterpret_cast<u32*>(m_Blocks + index * m_BlockStride));
 	}
 } // namespace aw::core
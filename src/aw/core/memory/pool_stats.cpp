@@ -0,0 +1,211 @@
+#include "aw/core/memory/pool_stats.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+namespace aw::core
+{
+	namespace
+	{
+		struct CountersRegistry
+		{
+			std::mutex				  mutex{};
+			ThreadAllocationCounters* head{};
+		};
+
+		// Never destroyed, threads can still exit after static destructors ran.
+		// Built in static storage, as operator new may be served by the pool that is being counted.
+		CountersRegistry& get_registry()
+		{
+			alignas(CountersRegistry) static std::byte storage[sizeof(CountersRegistry)];
+			static CountersRegistry*				   registry = std::construct_at(reinterpret_cast<CountersRegistry*>(storage));
+			return *registry;
+		}
+
+		thread_local bool t_CountersDestroyed = false;
+	} // namespace
+
+	// Folds the counters of the thread into the exited thread counters when the thread exits.
+	struct ThreadAllocationCountersOwner
+	{
+		~ThreadAllocationCountersOwner()
+		{
+			ThreadAllocationCounters* counters = ThreadAllocationCounters::t_Counters;
+			t_CountersDestroyed = true;
+			ThreadAllocationCounters::t_Counters = nullptr;
+			if (!counters)
+				return;
+
+			CountersRegistry& registry = get_registry();
+			std::lock_guard	  lock(registry.mutex);
+			for (u64 index = 0; index < SizeClasses::NUM_CLASSES; ++index)
+			{
+				ThreadAllocationCounters::s_ExitedThreadAllocations[index].fetch_add(counters->m_Allocations[index].load(std::memory_order::relaxed), std::memory_order::relaxed);
+				ThreadAllocationCounters::s_ExitedThreadFrees[index].fetch_add(counters->m_Frees[index].load(std::memory_order::relaxed), std::memory_order::relaxed);
+			}
+
+			if (counters->m_Prev)
+				counters->m_Prev->m_Next = counters->m_Next;
+			else
+				registry.head = counters->m_Next;
+
+			if (counters->m_Next)
+				counters->m_Next->m_Prev = counters->m_Prev;
+
+			std::destroy_at(counters);
+			free(counters);
+		}
+
+		bool registered{};
+	};
+
+	namespace
+	{
+		thread_local ThreadAllocationCountersOwner t_CountersOwner;
+	} // namespace
+
+	ThreadAllocationCounters* ThreadAllocationCounters::create()
+	{
+		if (t_CountersDestroyed)
+			return nullptr;
+
+		// Allocated with malloc, as the pool is what's being counted
+		const auto counters = static_cast<ThreadAllocationCounters*>(malloc(sizeof(ThreadAllocationCounters)));
+		if (!counters)
+			return nullptr;
+
+		std::construct_at(counters);
+		{
+			CountersRegistry& registry = get_registry();
+			std::lock_guard	  lock(registry.mutex);
+			counters->m_Next = registry.head;
+			if (registry.head)
+				registry.head->m_Prev = counters;
+			registry.head = counters;
+		}
+
+		t_Counters = counters;
+		t_CountersOwner.registered = true;
+		return counters;
+	}
+
+	void ThreadAllocationCounters::collect(PoolStats& stats)
+	{
+		std::array<u64, SizeClasses::NUM_CLASSES> allocations{};
+		std::array<u64, SizeClasses::NUM_CLASSES> frees{};
+		{
+			CountersRegistry& registry = get_registry();
+			std::lock_guard	  lock(registry.mutex);
+			for (u64 index = 0; index < SizeClasses::NUM_CLASSES; ++index)
+			{
+				allocations[index] = s_ExitedThreadAllocations[index].load(std::memory_order::relaxed);
+				frees[index] = s_ExitedThreadFrees[index].load(std::memory_order::relaxed);
+			}
+
+			for (const ThreadAllocationCounters* counters = registry.head; counters; counters = counters->m_Next)
+			{
+				for (u64 index = 0; index < SizeClasses::NUM_CLASSES; ++index)
+				{
+					allocations[index] += counters->m_Allocations[index].load(std::memory_order::relaxed);
+					frees[index] += counters->m_Frees[index].load(std::memory_order::relaxed);
+				}
+			}
+		}
+
+		for (u64 index = 0; index < SizeClasses::NUM_CLASSES; ++index)
+		{
+			// The counters of other threads are read while they keep changing, so a free can be seen before its allocation
+			SizeClassStats& size_class = stats.size_classes[index];
+			size_class.total_allocations = allocations[index];
+			size_class.live_blocks = allocations[index] > frees[index] ? allocations[index] - frees[index] : 0;
+		}
+	}
+
+	std::string PoolStats::to_string() const
+	{
+		std::string result;
+		result += std::format("committed: {} B (peak {} B), used: {} B, retained: {} B\n", committed_bytes, peak_committed_bytes, used_bytes, retained_bytes);
+		result += std::format("large allocations: {} live, {} B (peak {} B), {} total\n", live_large_allocations, large_allocation_bytes, peak_large_allocation_bytes, total_large_allocations);
+		result += std::format("buddy blocks: {} arenas, {} B committed, {} live ({} B), {} free ({} B), {} of {} allocations recycled\n",
+			buddy.num_arenas,
+			buddy.committed_bytes,
+			buddy.live_allocations,
+			buddy.live_block_bytes,
+			std::accumulate(buddy.free_blocks.begin(), buddy.free_blocks.end(), u64{ 0 }),
+			buddy.free_block_bytes,
+			buddy.recycled_allocations,
+			buddy.total_allocations);
+		result += std::format("{:>10} {:>6} {:>6} {:>12} {:>14} {:>14} {:>14} {:>12}\n", "block", "pages", "empty", "live blocks", "allocations", "committed B", "used B", "reclaimed");
+		for (const SizeClassStats& size_class : size_classes)
+		{
+			if (size_class.num_pages == 0 && size_class.total_allocations == 0)
+				continue;
+
+			result += std::format("{:>10} {:>6} {:>6} {:>12} {:>14} {:>14} {:>14} {:>12}\n",
+				size_class.block_size,
+				size_class.num_pages,
+				size_class.num_empty_pages,
+				size_class.live_blocks,
+				size_class.total_allocations,
+				size_class.committed_bytes,
+				size_class.used_bytes,
+				size_class.reclaimed_blocks);
+		}
+
+		return result;
+	}
+
+	std::string PoolStats::to_json() const
+	{
+		nlohmann::json document = {
+			{ "committed_bytes", committed_bytes },
+			{ "peak_committed_bytes", peak_committed_bytes },
+			{ "used_bytes", used_bytes },
+			{ "retained_bytes", retained_bytes },
+			{ "large_allocations",
+				{
+					{ "live", live_large_allocations },
+					{ "total", total_large_allocations },
+					{ "bytes", large_allocation_bytes },
+					{ "peak_bytes", peak_large_allocation_bytes },
+				} },
+			{ "buddy",
+				{
+					{ "num_arenas", buddy.num_arenas },
+					{ "committed_bytes", buddy.committed_bytes },
+					{ "live_allocations", buddy.live_allocations },
+					{ "total_allocations", buddy.total_allocations },
+					{ "recycled_allocations", buddy.recycled_allocations },
+					{ "live_block_bytes", buddy.live_block_bytes },
+					{ "free_block_bytes", buddy.free_block_bytes },
+					{ "free_blocks", buddy.free_blocks },
+				} },
+		};
+
+		nlohmann::json& classes = document["size_classes"] = nlohmann::json::array();
+		for (const SizeClassStats& size_class : size_classes)
+		{
+			if (size_class.num_pages == 0 && size_class.total_allocations == 0)
+				continue;
+
+			classes.push_back({
+				{ "block_size", size_class.block_size },
+				{ "num_pages", size_class.num_pages },
+				{ "num_empty_pages", size_class.num_empty_pages },
+				{ "live_blocks", size_class.live_blocks },
+				{ "total_allocations", size_class.total_allocations },
+				{ "committed_bytes", size_class.committed_bytes },
+				{ "used_bytes", size_class.used_bytes },
+				{ "reclaimed_blocks", size_class.reclaimed_blocks },
+			});
+		}
+
+		return document.dump();
+	}
+} // namespace aw::core
@@ -0,0 +1,10 @@
+#include "aw/core/memory/stack_allocator.h"
+
+namespace aw::core
+{
+	StackAllocator& StackAllocator::get()
+	{
+		thread_local StackAllocator stack;
+		return stack;
+	}
+} // namespace aw::core
@@ -0,0 +1,191 @@
+#include "aw/core/memory/thread_cache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace aw::core
+{
+	namespace
+	{
+		thread_local ThreadCache* t_ThreadCache = nullptr;
+		thread_local bool		  t_ThreadCacheDestroyed = false;
+
+		// Flushes and destroys the cache of the thread when the thread exits.
+		struct ThreadCacheOwner
+		{
+			~ThreadCacheOwner()
+			{
+				if (t_ThreadCache)
+				{
+					std::destroy_at(t_ThreadCache);
+					free(t_ThreadCache);
+					t_ThreadCache = nullptr;
+				}
+				t_ThreadCacheDestroyed = true;
+			}
+
+			bool registered{};
+		};
+
+		thread_local ThreadCacheOwner t_ThreadCacheOwner;
+	} // namespace
+
+	ThreadCache* ThreadCache::get()
+	{
+		if (get_depth() == 0 || t_ThreadCacheDestroyed)
+		{
+			return nullptr;
+		}
+
+		if (!t_ThreadCache)
+		{
+			// The cache is allocated with malloc, as it can't be served by the pool it sits in front of.
+			const auto cache = static_cast<ThreadCache*>(malloc(sizeof(ThreadCache)));
+			if (!cache)
+			{
+				return nullptr;
+			}
+
+			std::construct_at(cache);
+			t_ThreadCache = cache;
+			t_ThreadCacheOwner.registered = true;
+		}
+
+		return t_ThreadCache;
+	}
+
+	void ThreadCache::set_depth(const u32 depth)
+	{
+		s_Depth.store(std::min(depth, MAX_DEPTH), std::memory_order::relaxed);
+	}
+
+	ThreadCache::~ThreadCache()
+	{
+		flush();
+		for (Magazine& magazine : m_Magazines)
+		{
+			free(magazine.blocks);
+		}
+	}
+
+	void* ThreadCache::allocate(PagedMemoryPool& pool, const u64 size_class_index, const u64 requested_size)
+	{
+		Magazine& magazine = m_Magazines[size_class_index];
+		if (magazine.count == 0)
+		{
+			PageTree* page_tree = pool.get_page_tree(size_class_index);
+
+			const u32 depth = get_depth();
+			if (!reserve_magazine(magazine, depth))
+			{
+				return page_tree->allocate_block(requested_size);
+			}
+
+			// Refill only half of the magazine, so the frees that follow don't flush it right away.
+			magazine.count = refill(magazine, page_tree, requested_size, std::max(depth / 2, 1u));
+			if (magazine.count == 0)
+			{
+				return nullptr;
+			}
+		}
+
+		void* block = magazine.blocks[--magazine.count];
+		if constexpr (!HEADERLESS_ALLOCATIONS)
+		{
+			(static_cast<AllocationHeader*>(block) - 1)->alloc_size = to_u32(requested_size);
+		}
+		return block;
+	}
+
+	void ThreadCache::deallocate(void* block, const u64 size_class_index)
+	{
+		Magazine& magazine = m_Magazines[size_class_index];
+
+		const u32 depth = get_depth();
+		if (magazine.count >= depth)
+		{
+			flush_oldest(magazine, magazine.count - depth / 2);
+		}
+
+		if (!reserve_magazine(magazine, depth) || magazine.count >= depth)
+		{
+			MemoryPage::free_block(block);
+			return;
+		}
+
+		magazine.blocks[magazine.count++] = block;
+	}
+
+	void ThreadCache::flush()
+	{
+		for (Magazine& magazine : m_Magazines)
+		{
+			flush_oldest(magazine, magazine.count);
+			release_owned_page(magazine);
+		}
+	}
+
+	bool ThreadCache::reserve_magazine(Magazine& magazine, const u32 depth)
+	{
+		if (magazine.capacity >= depth)
+		{
+			return true;
+		}
+
+		const auto blocks = static_cast<void**>(malloc(depth * sizeof(void*)));
+		if (!blocks)
+		{
+			return false;
+		}
+
+		if (magazine.blocks)
+		{
+			std::memcpy(blocks, magazine.blocks, magazine.count * sizeof(void*));
+			free(magazine.blocks);
+		}
+
+		magazine.blocks = blocks;
+		magazine.capacity = depth;
+		return true;
+	}
+
+	u32 ThreadCache::refill(Magazine& magazine, PageTree* page_tree, const u64 requested_size, const u32 count)
+	{
+		if (magazine.owned_page)
+		{
+			if (const u32 num_reclaimed = magazine.owned_page->reclaim_blocks(magazine.reclaimed, magazine.blocks, count))
+			{
+				return num_reclaimed;
+			}
+
+			// Nothing was freed to the page since the last refill, so move on to the page the tree hands out next
+			release_owned_page(magazine);
+		}
+
+		return page_tree->allocate_blocks(requested_size, magazine.blocks, count, &magazine.owned_page);
+	}
+
+	void ThreadCache::release_owned_page(Magazine& magazine)
+	{
+		if (magazine.owned_page)
+		{
+			magazine.owned_page->release_ownership(magazine.reclaimed);
+			magazine.owned_page = nullptr;
+			magazine.reclaimed = PageFreeList::INVALID_INDEX;
+		}
+	}
+
+	void ThreadCache::flush_oldest(Magazine& magazine, const u32 count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		MemoryPage::free_blocks(magazine.blocks, count);
+		magazine.count -= count;
+		std::memmove(magazine.blocks, magazine.blocks + count, magazine.count * sizeof(void*));
+	}
+} // namespace aw::core
@@ -0,0 +1,136 @@
+#include "aw/core/memory/virtual_memory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+namespace aw::core
+{
+	u64 VirtualMemory::get_page_size()
+	{
+#ifdef _WIN32
+		static const u64 page_size = [] {
+			SYSTEM_INFO info{};
+			GetSystemInfo(&info);
+			return static_cast<u64>(info.dwPageSize);
+		}();
+#else
+		static const u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+#endif
+		return page_size;
+	}
+
+	void* VirtualMemory::reserve(const u64 size, const u64 alignment)
+	{
+#ifdef _WIN32
+		// Windows can't release a part of a reservation, so find an aligned hole with an oversized reservation
+		// and reserve exactly at it. Another thread may take the hole in between, so retry a few times.
+		for (u32 attempt = 0; attempt < 8; ++attempt)
+		{
+			void* probe = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+			if (!probe)
+				return nullptr;
+
+			const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(probe) + alignment - 1) & ~(alignment - 1);
+			VirtualFree(probe, 0, MEM_RELEASE);
+
+			if (void* memory = VirtualAlloc(reinterpret_cast<void*>(aligned), size, MEM_RESERVE, PAGE_NOACCESS))
+				return memory;
+		}
+		return nullptr;
+#else
+		// Over-reserve and unmap the parts in front of and behind the aligned range
+		const u64 reserved_size = size + alignment;
+		void*	  probe = mmap(nullptr, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (probe == MAP_FAILED)
+			return nullptr;
+
+		const auto			 start = reinterpret_cast<std::uintptr_t>(probe);
+		const std::uintptr_t aligned = (start + alignment - 1) & ~(alignment - 1);
+		if (const u64 head = aligned - start; head > 0)
+			munmap(probe, head);
+
+		if (const u64 tail = start + reserved_size - (aligned + size); tail > 0)
+			munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+		return reinterpret_cast<void*>(aligned);
+#endif
+	}
+
+	bool VirtualMemory::commit(void* address, const u64 size)
+	{
+#ifdef _WIN32
+		return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+		return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+	}
+
+	void VirtualMemory::prefault(void* address, const u64 size)
+	{
+#ifdef __linux__
+		// Since Linux 5.14, the whole range is faulted in with a single call
+#ifndef MADV_POPULATE_WRITE
+		constexpr int MADV_POPULATE_WRITE = 23;
+#endif
+		if (madvise(address, size, MADV_POPULATE_WRITE) == 0)
+			return;
+#endif
+
+		// Write every page back with its own value
+		const u64 page_size = get_page_size();
+		for (volatile u8* byte = static_cast<u8*>(address); byte < static_cast<u8*>(address) + size; byte += page_size)
+		{
+			*byte = *byte;
+		}
+	}
+
+	void VirtualMemory::decommit(void* address, const u64 size)
+	{
+#ifdef _WIN32
+		VirtualFree(address, size, MEM_DECOMMIT);
+#else
+		madvise(address, size, MADV_DONTNEED);
+		mprotect(address, size, PROT_NONE);
+#endif
+	}
+
+	bool VirtualMemory::remap(void* address, const u64 size, void* new_address)
+	{
+#ifdef __linux__
+		return mremap(address, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, new_address) != MAP_FAILED;
+#else
+		(void)address;
+		(void)size;
+		(void)new_address;
+		return false;
+#endif
+	}
+
+	void VirtualMemory::release(void* address, const u64 size)
+	{
+#ifdef _WIN32
+		(void)size;
+		VirtualFree(address, 0, MEM_RELEASE);
+#else
+		munmap(address, size);
+#endif
+	}
+
+	void VirtualMemory::advise_huge_pages(void* address, const u64 size)
+	{
+#ifdef MADV_HUGEPAGE
+		madvise(address, size, MADV_HUGEPAGE);
+#else
+		(void)address;
+		(void)size;
+#endif
+	}
+} // namespace aw::core
@@ -0,0 +1,171 @@
+// Replaces the global operator new and delete with the default heap of the PagedMemoryPool.
+// Built as an object library of its own (aw::CoreNewDelete), so only the executables that link it get the replacement.
+//
+// The default heap is created on the first allocation, also when that happens during static initialization, and it is never
+// destroyed, so objects that are destroyed late during shutdown still free into it. Nothing on the allocation path of the pool
+// uses operator new: the thread caches, counters and profiler samples are malloc'ed or live in static storage.
+//
+// Alignments above PagedMemoryPool::MAX_ALIGNMENT (half a page) can't be served by the pool, new throws std::bad_alloc for them
+// without calling the new handler, and the nothrow forms return nullptr.
+
+#include "aw/core/memory/paged_memory_pool.h"
+
+#include <cstddef>
+#include <new>
+
+namespace
+{
+	using aw::core::PagedMemoryPool;
+
+	// operator new has to return a distinct pointer for 0 bytes, the pool returns nullptr for them
+	std::size_t get_request_size(const std::size_t size)
+	{
+		return size != 0 ? size : 1;
+	}
+
+	void* try_allocate(const std::size_t size, const std::align_val_t alignment)
+	{
+		// Pooled memory is aligned for any fundamental type already
+		const auto align = static_cast<aw::core::u64>(alignment);
+		if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			return PagedMemoryPool::get().allocate_memory(aw::core::Bytes(get_request_size(size)));
+
+		return PagedMemoryPool::get().allocate_memory_aligned(aw::core::Bytes(get_request_size(size)), align);
+	}
+
+	// Retries through the new handler until the allocation succeeds, like the operator new of the standard library
+	void* allocate(const std::size_t size, const std::align_val_t alignment)
+	{
+		// Freeing memory wouldn't help, so the new handler isn't asked
+		if (static_cast<aw::core::u64>(alignment) > PagedMemoryPool::MAX_ALIGNMENT) [[unlikely]]
+			throw std::bad_alloc();
+
+		while (true)
+		{
+			if (void* memory = try_allocate(size, alignment)) [[likely]]
+				return memory;
+
+			const std::new_handler handler = std::get_new_handler();
+			if (!handler)
+				throw std::bad_alloc();
+
+			handler();
+		}
+	}
+
+	void* allocate_nothrow(const std::size_t size, const std::align_val_t alignment) noexcept
+	{
+		try
+		{
+			return allocate(size, alignment);
+		}
+		catch (...)
+		{
+			return nullptr;
+		}
+	}
+
+	constexpr std::align_val_t DEFAULT_ALIGNMENT{ __STDCPP_DEFAULT_NEW_ALIGNMENT__ };
+} // namespace
+
+void* operator new(const std::size_t size)
+{
+	return allocate(size, DEFAULT_ALIGNMENT);
+}
+
+void* operator new[](const std::size_t size)
+{
+	return allocate(size, DEFAULT_ALIGNMENT);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate_nothrow(size, DEFAULT_ALIGNMENT);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate_nothrow(size, DEFAULT_ALIGNMENT);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	return allocate(size, alignment);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+	return allocate(size, alignment);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate_nothrow(size, alignment);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate_nothrow(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+// The size is the one new was called with, which picks the same size class without looking at the page
+void operator delete(void* ptr, const std::size_t size) noexcept
+{
+	PagedMemoryPool::free_memory(ptr, aw::core::Bytes(get_request_size(size)));
+}
+
+void operator delete[](void* ptr, const std::size_t size) noexcept
+{
+	PagedMemoryPool::free_memory(ptr, aw::core::Bytes(get_request_size(size)));
+}
+
+// Aligned memory may sit inside of a bigger block, so it's freed through its page
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	PagedMemoryPool::free_memory(ptr);
+}
@@ -0,0 +1,741 @@
+#include <gtest/gtest.h>
+
+#include "aw/core/all.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace aw::core;
+
+TEST(AllocatorTests, TestLinearArena)
+{
+	LinearArena arena(4096);
+	EXPECT_EQ(arena.get_reserved_bytes(), 0);
+
+	// Consecutive allocations are bumped from the same chunk
+	auto* first = static_cast<u8*>(arena.allocate(100));
+	auto* second = static_cast<u8*>(arena.allocate(100));
+	ASSERT_NE(first, nullptr);
+	EXPECT_EQ(second, first + Math::align_up(100, alignof(std::max_align_t)));
+	EXPECT_EQ(arena.get_reserved_bytes(), 4096);
+
+	void* aligned = arena.allocate(10, 256);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 256, 0);
+
+	// Overflowing the chunk takes another one, an oversized allocation gets a chunk of its own size
+	for (u32 index = 0; index < 100; ++index)
+	{
+		std::memset(arena.allocate(64), 0xAB, 64);
+	}
+	void* oversized = arena.allocate(20000);
+	ASSERT_NE(oversized, nullptr);
+	std::memset(oversized, 0xCD, 20000);
+	const usize reserved_bytes = arena.get_reserved_bytes();
+	EXPECT_GT(reserved_bytes, 20000);
+
+	// Reset rewinds to the first chunk and the same workload doesn't reserve more
+	arena.reset();
+	EXPECT_EQ(arena.allocate(100), first);
+	for (u32 index = 0; index < 100; ++index)
+	{
+		std::memset(arena.allocate(64), 0xAB, 64);
+	}
+	EXPECT_NE(arena.allocate(20000), nullptr);
+	EXPECT_EQ(arena.get_reserved_bytes(), reserved_bytes);
+
+	arena.release();
+	EXPECT_EQ(arena.get_reserved_bytes(), 0);
+	EXPECT_NE(arena.allocate(0), nullptr);
+}
+
+TEST(AllocatorTests, TestArenaAllocator)
+{
+	LinearArena arena;
+	{
+		Vector<u32, ArenaAllocator<u32>> vector(arena);
+		for (u32 index = 0; index < 1000; ++index)
+		{
+			vector.push_back(index);
+		}
+		EXPECT_EQ(vector[999], 999);
+
+		HashMap<u32, u32, std::hash<u32>, std::equal_to<u32>, ArenaAllocator<std::pair<const u32, u32>>> map(arena);
+		for (u32 index = 0; index < 100; ++index)
+		{
+			map[index] = index * 2;
+		}
+		EXPECT_EQ(map.at(50), 100);
+
+		Queue<u32, ArenaAllocator<u32>> queue(ArenaAllocator<u32>{ arena });
+		queue.push(1);
+		queue.push(2);
+		EXPECT_EQ(queue.front(), 1);
+
+		// Copies keep allocating from the same arena
+		const Vector<u32, ArenaAllocator<u32>> copy = vector;
+		EXPECT_EQ(copy.get_allocator().get_arena(), &arena);
+		EXPECT_EQ(copy.get_allocator(), ArenaAllocator<u64>(arena));
+	}
+
+	const usize reserved_bytes = arena.get_reserved_bytes();
+	EXPECT_GT(reserved_bytes, 0);
+	arena.reset();
+
+	Vector<u32, ArenaAllocator<u32>> vector(arena);
+	vector.resize(100);
+	EXPECT_EQ(arena.get_reserved_bytes(), reserved_bytes);
+}
+
+TEST(AllocatorTests, TestStackAllocator)
+{
+	StackAllocator stack(4096);
+
+	// Every nesting level reuses the memory of the previous one at the same depth
+	const StackAllocator::Marker outer = stack.push();
+	u32*						 first = stack.allocate_array<u32>(16);
+	{
+		const StackAllocatorScope scope = stack.scope();
+		u32*					  nested = stack.allocate_array<u32>(16);
+		EXPECT_GT(nested, first);
+
+		// Spill over into the next chunks, the scope rewinds across them
+		for (u32 index = 0; index < 100; ++index)
+		{
+			std::memset(stack.allocate(256), 0xAB, 256);
+		}
+	}
+	const usize reserved_bytes = stack.get_arena().get_reserved_bytes();
+
+	{
+		const StackAllocatorScope scope = stack.scope();
+		EXPECT_EQ(stack.allocate_array<u32>(16), first + 16);
+		for (u32 index = 0; index < 100; ++index)
+		{
+			std::memset(stack.allocate(256), 0xAB, 256);
+		}
+		EXPECT_EQ(stack.get_arena().get_reserved_bytes(), reserved_bytes);
+	}
+
+	stack.pop(outer);
+	EXPECT_EQ(stack.allocate_array<u32>(16), first);
+
+	// Containers can use the stack through its arena
+	{
+		const StackAllocatorScope		 scope = stack.scope();
+		Vector<u32, ArenaAllocator<u32>> vector(stack.get_arena());
+		vector.resize(100, 7);
+		EXPECT_EQ(vector[99], 7);
+	}
+}
+
+TEST(AllocatorTests, TestThreadLocalStackAllocator)
+{
+	constexpr u32 num_tasks = 16;
+	ThreadPool	  pool(4);
+
+	Vector<std::future<StackAllocator*>> results;
+	for (u32 task = 0; task < num_tasks; ++task)
+	{
+		results.push_back(pool.submit_task([] {
+			StackAllocator& stack = StackAllocator::get();
+			const auto		scope = stack.scope();
+			auto*			scratch = static_cast<u8*>(stack.allocate(1024));
+			std::memset(scratch, 0xCD, 1024);
+			return &stack;
+		}));
+	}
+
+	for (std::future<StackAllocator*>& result : results)
+	{
+		// Every worker has a stack of its own
+		EXPECT_NE(result.get(), &StackAllocator::get());
+	}
+	EXPECT_EQ(&StackAllocator::get(), &StackAllocator::get());
+}
+
+TEST(AllocatorTests, TestObjectPool)
+{
+	struct Particle
+	{
+		f32 position[3]{};
+		f32 velocity[3]{};
+	};
+
+	ObjectPool<Particle> pool(4096);
+	EXPECT_EQ(pool.get_num_slabs(), 0);
+
+	// Objects are handed out back to back from the slab
+	Particle* first = pool.create();
+	Particle* second = pool.create();
+	EXPECT_EQ(second, first + 1);
+	EXPECT_EQ(pool.get_num_slabs(), 1);
+
+	// A destroyed object is the next one to be reused
+	pool.destroy(first);
+	EXPECT_EQ(pool.create(), first);
+
+	Vector<Particle*> particles;
+	for (usize index = 0; index < pool.get_objects_per_slab(); ++index)
+	{
+		particles.push_back(pool.create());
+		particles.back()->velocity[2] = 1.0f;
+	}
+	EXPECT_EQ(pool.get_num_slabs(), 2);
+
+	for (Particle* particle : particles)
+	{
+		pool.destroy(particle);
+	}
+	pool.destroy(first);
+	pool.destroy(second);
+}
+
+TEST(AllocatorTests, TestObjectPoolThreadCaches)
+{
+	struct Node
+	{
+		u64 values[4]{};
+	};
+
+	ObjectPool<Node>& pool = ObjectPool<Node>::get();
+	ThreadPool		  threads(4);
+
+	// Objects created on one thread and destroyed on another end up in the cache of the destroying thread
+	Vector<std::future<Vector<Node*>>> created;
+	for (u32 task = 0; task < 8; ++task)
+	{
+		created.push_back(threads.submit_task([&pool, task] {
+			Vector<Node*> nodes;
+			for (u64 index = 0; index < 1000; ++index)
+			{
+				nodes.push_back(pool.create());
+				nodes.back()->values[0] = task;
+			}
+			return nodes;
+		}));
+	}
+
+	Vector<std::future<void>> destroyed;
+	for (std::future<Vector<Node*>>& nodes : created)
+	{
+		destroyed.push_back(threads.submit_task([&pool, nodes = nodes.get()] {
+			for (Node* node : nodes)
+			{
+				pool.destroy(node);
+			}
+		}));
+	}
+
+	for (std::future<void>& result : destroyed)
+	{
+		result.get();
+	}
+
+	// 8000 objects don't need more than a few slabs, even with the slots sitting in the thread caches
+	EXPECT_LE(pool.get_num_slabs() * pool.get_objects_per_slab(), 8000 + 2 * 4 * ObjectPool<Node>::THREAD_CACHE_SIZE + pool.get_objects_per_slab());
+}
+
+namespace
+{
+	struct LateNode
+	{
+		u64 value{};
+	};
+
+	// Constructed before the thread cache of the pool, so it's destroyed after it
+	struct LateNodeHolder
+	{
+		~LateNodeHolder() { ObjectPool<LateNode>::get().destroy(node); }
+
+		LateNode* node{};
+	};
+} // namespace
+
+TEST(AllocatorTests, TestObjectPoolFreeAfterThreadCache)
+{
+	std::thread([] {
+		thread_local LateNodeHolder holder;
+		holder.node = ObjectPool<LateNode>::get().create();
+	}).join();
+
+	// The holder freed its node after the thread cache was gone, straight into the pool
+	LateNode* node = ObjectPool<LateNode>::get().create();
+	EXPECT_NE(node, nullptr);
+	ObjectPool<LateNode>::get().destroy(node);
+}
+
+namespace
+{
+	struct PooledObject : PooledRefCounted<PooledObject>
+	{
+		explicit PooledObject(u32* in_num_destroyed)
+			: num_destroyed(in_num_destroyed)
+		{
+		}
+
+		~PooledObject() override
+		{
+			++*num_destroyed;
+		}
+
+		u32* num_destroyed{};
+	};
+} // namespace
+
+TEST(AllocatorTests, TestPooledRefCounted)
+{
+	u32 num_destroyed = 0;
+
+	PooledObject* address = nullptr;
+	{
+		RefPtr<PooledObject> object = new_ref<PooledObject>(&num_destroyed);
+		RefPtr<PooledObject> copy = object;
+		address = object.get();
+		EXPECT_EQ(object->get_ref_count(), 2);
+	}
+	EXPECT_EQ(num_destroyed, 1);
+
+	// The last release gave the object back to its pool
+	const RefPtr<PooledObject> object = new_ref<PooledObject>(&num_destroyed);
+	EXPECT_EQ(object.get(), address);
+}
+
+namespace
+{
+	template <typename CountPolicy>
+	struct CountedObject : RefCounted<CountedObject<CountPolicy>, CountPolicy>
+	{
+		explicit CountedObject(u32* in_num_destroyed)
+			: num_destroyed(in_num_destroyed)
+		{
+		}
+
+		~CountedObject()
+		{
+			++*num_destroyed;
+		}
+
+		u32* num_destroyed{};
+	};
+
+	struct PooledCountedObject : RefCounted<PooledCountedObject, SingleThreadedRefCount>
+	{
+		using PooledType = PooledCountedObject;
+
+		u64 payload{};
+	};
+} // namespace
+
+TEST(AllocatorTests, TestRefCountedPolicies)
+{
+	u32 num_destroyed = 0;
+	{
+		RefPtr<CountedObject<SingleThreadedRefCount>> object = new_ref<CountedObject<SingleThreadedRefCount>>(&num_destroyed);
+		RefPtr<CountedObject<SingleThreadedRefCount>> copy = object;
+		EXPECT_EQ(object->get_ref_count(), 2);
+
+		// A copy of the object itself starts with a count of its own
+		const CountedObject<SingleThreadedRefCount> copied_object = *object;
+		EXPECT_EQ(copied_object.get_ref_count(), 1);
+
+		RefPtr<CountedObject<SingleThreadedRefCount>> moved = std::move(copy);
+		EXPECT_EQ(object->get_ref_count(), 2);
+		moved.reset();
+		EXPECT_EQ(object->get_ref_count(), 1);
+	}
+	EXPECT_EQ(num_destroyed, 2);
+
+	{
+		RefPtr<CountedObject<AtomicRefCount>> object = new_ref<CountedObject<AtomicRefCount>>(&num_destroyed);
+		std::vector<std::thread> threads;
+		for (u32 thread_index = 0; thread_index < 4; ++thread_index)
+		{
+			threads.emplace_back([object] {
+				for (u32 index = 0; index < 10'000; ++index)
+				{
+					RefPtr<CountedObject<AtomicRefCount>> copy = object;
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		EXPECT_EQ(object->get_ref_count(), 1);
+	}
+	EXPECT_EQ(num_destroyed, 3);
+
+	// The last release gives pooled objects back to their pool
+	PooledCountedObject* address = new_ref<PooledCountedObject>().get();
+	EXPECT_EQ(new_ref<PooledCountedObject>().get(), address);
+}
+
+namespace
+{
+	struct WeakTarget : IntrusiveRefCounted
+	{
+		explicit WeakTarget(std::atomic<u32>* in_num_destroyed)
+			: num_destroyed(in_num_destroyed)
+		{
+		}
+
+		~WeakTarget() override
+		{
+			++*num_destroyed;
+		}
+
+		std::atomic<u32>* num_destroyed{};
+	};
+} // namespace
+
+TEST(AllocatorTests, TestWeakRefPtr)
+{
+	std::atomic<u32> num_destroyed = 0;
+	{
+		RefPtr<WeakTarget>	   object = new_ref<WeakTarget>(&num_destroyed);
+		WeakRefPtr<WeakTarget> weak = object;
+		WeakRefPtr<WeakTarget> copy = weak;
+		EXPECT_EQ(object->get_ref_count(), 1);
+
+		// All weak references share the block of the object
+		EXPECT_EQ(object->get_weak_control_block(), WeakRefPtr<WeakTarget>(object.get()).lock()->get_weak_control_block());
+		{
+			const RefPtr<WeakTarget> locked = weak.lock();
+			EXPECT_EQ(locked.get(), object.get());
+			EXPECT_EQ(object->get_ref_count(), 2);
+		}
+
+		// The weak references don't keep the object alive, and the block outlives it
+		object.reset();
+		EXPECT_EQ(num_destroyed, 1);
+		EXPECT_TRUE(weak.is_expired());
+		EXPECT_EQ(weak.lock().get(), nullptr);
+
+		WeakRefPtr<WeakTarget> moved = std::move(copy);
+		EXPECT_TRUE(moved.is_expired());
+		EXPECT_TRUE(copy.is_expired());
+	}
+
+	// Upgrades racing with the release of the last strong reference either get the object or nothing
+	for (u32 round = 0; round < 200; ++round)
+	{
+		RefPtr<WeakTarget>		 object = new_ref<WeakTarget>(&num_destroyed);
+		const WeakRefPtr<WeakTarget> weak = object;
+		std::atomic<bool>		 start = false;
+		std::vector<std::thread> threads;
+		for (u32 thread_index = 0; thread_index < 4; ++thread_index)
+		{
+			threads.emplace_back([&weak, &start] {
+				while (!start.load(std::memory_order::acquire))
+				{
+				}
+
+				for (u32 index = 0; index < 100; ++index)
+				{
+					if (const RefPtr<WeakTarget> locked = weak.lock())
+					{
+						EXPECT_GE(locked->get_ref_count(), 1);
+					}
+				}
+			});
+		}
+
+		start.store(true, std::memory_order::release);
+		object.reset();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		EXPECT_TRUE(weak.is_expired());
+	}
+	EXPECT_EQ(num_destroyed, 201);
+}
+
+TEST(AllocatorTests, TestStaticAllocatorCoalescing)
+{
+	StaticAllocator<u64, 64 * sizeof(u64)> allocator;
+	EXPECT_EQ(allocator.get_max_allocation(), 64);
+
+	u64* first = allocator.allocate(20);
+	u64* second = allocator.allocate(20);
+	u64* third = allocator.allocate(20);
+	EXPECT_EQ(second, first + 20);
+	EXPECT_EQ(allocator.get_max_allocation(), 4);
+	EXPECT_THROW((void)allocator.allocate(5), std::bad_alloc);
+
+	// Neighbouring free ranges merge, so the two freed ranges fit a bigger allocation
+	allocator.deallocate(first, 20);
+	allocator.deallocate(second, 20);
+	EXPECT_EQ(allocator.get_max_allocation(), 40);
+	EXPECT_EQ(allocator.allocate(40), first);
+
+	allocator.deallocate(first, 40);
+	allocator.deallocate(third, 20);
+	EXPECT_EQ(allocator.get_max_allocation(), 64);
+}
+
+TEST(AllocatorTests, TestStaticAllocatorChurn)
+{
+	// Runs cross the words of the bitmap
+	constexpr usize num_elements = 1200;
+	constexpr u32	max_live = 8;
+	constexpr u32	max_count = 64;
+	using Allocator = StaticAllocator<u32, num_elements * sizeof(u32)>;
+
+	// At most 8 allocations of up to 64 elements leave 688 free elements in at most 9 ranges, so every allocation fits
+	Allocator								   allocator;
+	std::array<std::pair<u32*, u32>, max_live> live{};
+	u32										   seed = 12345;
+	for (u32 cycle = 0; cycle < 5000; ++cycle)
+	{
+		seed = seed * 1664525 + 1013904223;
+		auto& [memory, count] = live[(seed >> 8) % max_live];
+		if (memory)
+		{
+			EXPECT_TRUE(std::all_of(memory, memory + count, [count](const u32 value) { return value == count; }));
+			allocator.deallocate(memory, count);
+		}
+
+		count = 1 + (seed >> 16) % max_count;
+		memory = allocator.allocate(count);
+		std::fill_n(memory, count, count);
+	}
+
+	for (auto& [memory, count] : live)
+	{
+		allocator.deallocate(memory, count);
+	}
+	EXPECT_EQ(allocator.get_max_allocation(), num_elements);
+
+	// Containers grow in their own buffer
+	Vector<u32, Allocator> vector;
+	for (u32 index = 0; index < 300; ++index)
+	{
+		vector.push_back(index);
+	}
+	EXPECT_EQ(vector[299], 299);
+
+	// The allocators don't propagate, so the elements are moved into the buffer of the target
+	Vector<u32, Allocator> source(100, 7);
+	Vector<u32, Allocator> target;
+	target = std::move(source);
+	EXPECT_EQ(target.size(), 100);
+	EXPECT_EQ(target[99], 7);
+}
+
+namespace
+{
+	// Owns a heap allocation and doesn't point into itself, so it can be relocated by copying its bytes
+	struct OwnedBuffer
+	{
+		explicit OwnedBuffer(const u32 value)
+			: value(new u32(value))
+		{
+		}
+
+		OwnedBuffer(const OwnedBuffer& other)
+			: value(new u32(*other.value))
+		{
+		}
+
+		~OwnedBuffer() { delete value; }
+
+		OwnedBuffer& operator=(const OwnedBuffer&) = delete;
+
+		u32* value{};
+	};
+} // namespace
+
+template <>
+struct aw::core::is_trivially_relocatable<OwnedBuffer> : std::true_type
+{
+};
+
+TEST(AllocatorTests, TestRelocatableVector)
+{
+	// Stays below the size classes of the PagedMemoryPool tests, which expect fresh pages
+	RelocatableVector<u64> numbers;
+	for (u64 index = 0; index < 10'000; ++index)
+	{
+		numbers.push_back(index);
+	}
+	EXPECT_EQ(numbers.size(), 10'000);
+	EXPECT_GE(numbers.capacity(), numbers.size());
+	for (u64 index = 0; index < numbers.size(); ++index)
+	{
+		ASSERT_EQ(numbers[index], index);
+	}
+
+	// The capacity covers the whole block
+	RelocatableVector<u64> small{ 1, 2, 3 };
+	EXPECT_EQ(small.capacity() * sizeof(u64), get_usable_allocation_size(small.data()));
+
+	// Pushing an element of the vector itself while it grows
+	small.resize(small.capacity());
+	small.push_back(small.front());
+	EXPECT_EQ(small.back(), 1);
+
+	small.erase(small.begin());
+	EXPECT_EQ(small.front(), 2);
+	small.resize(2);
+	small.shrink_to_fit();
+	EXPECT_EQ(small.size(), 2);
+	EXPECT_EQ(small[1], 3);
+
+	RelocatableVector<u64> copy = numbers;
+	EXPECT_EQ(copy.back(), numbers.back());
+	RelocatableVector<u64> moved = std::move(copy);
+	EXPECT_TRUE(copy.empty());
+	EXPECT_EQ(moved.size(), numbers.size());
+
+	// Elements with destructors are relocated without being moved or destroyed on the way
+	{
+		RelocatableVector<OwnedBuffer> buffers;
+		for (u32 index = 0; index < 1000; ++index)
+		{
+			buffers.emplace_back(index);
+		}
+		for (u32 index = 0; index < 1000; ++index)
+		{
+			ASSERT_EQ(*buffers[index].value, index);
+		}
+
+		buffers.erase(buffers.begin() + 10);
+		EXPECT_EQ(*buffers[10].value, 11);
+		buffers.pop_back();
+		EXPECT_EQ(buffers.size(), 998);
+	}
+}
+
+namespace
+{
+	// Owns memory, so elements that are copied but never destroyed show up as leaks
+	struct ThrowingCopy
+	{
+		ThrowingCopy() = default;
+
+		ThrowingCopy(const ThrowingCopy& other)
+			: value(std::make_unique<u32>(*other.value))
+		{
+			if (s_CopiesLeft-- == 0)
+				throw std::runtime_error("copy failed");
+		}
+
+		std::unique_ptr<u32> value = std::make_unique<u32>(0);
+
+		static inline u32 s_CopiesLeft = std::numeric_limits<u32>::max();
+	};
+} // namespace
+
+TEST(AllocatorTests, TestFlatHashMap)
+{
+	// Integer keys, with std::hash being the identity
+	HashMap<u32, u32> map;
+	for (u32 index = 0; index < 10'000; ++index)
+	{
+		map[index] = index * 2;
+	}
+	EXPECT_EQ(map.size(), 10'000);
+	EXPECT_LE(map.size(), map.capacity() - map.capacity() / 8);
+	for (u32 index = 0; index < 10'000; ++index)
+	{
+		ASSERT_EQ(map.at(index), index * 2);
+	}
+	EXPECT_FALSE(map.contains(10'000));
+	EXPECT_EQ(map.find(10'000), map.end());
+	EXPECT_THROW((void)map.at(10'000), std::out_of_range);
+
+	// Erasing half of the keys, then inserting new ones into the deleted slots
+	for (u32 index = 0; index < 10'000; index += 2)
+	{
+		ASSERT_EQ(map.erase(index), 1);
+	}
+	EXPECT_EQ(map.erase(0), 0);
+	EXPECT_EQ(map.size(), 5'000);
+	const usize capacity = map.capacity();
+	for (u32 round = 0; round < 10; ++round)
+	{
+		for (u32 index = 0; index < 10'000; index += 2)
+		{
+			EXPECT_TRUE(map.try_emplace(index + 20'000 * (round + 1), round).second);
+		}
+		for (u32 index = 0; index < 10'000; index += 2)
+		{
+			map.erase(index + 20'000 * (round + 1));
+		}
+	}
+	EXPECT_EQ(map.capacity(), capacity);
+
+	u64 sum = 0;
+	for (const auto& [key, value] : map)
+	{
+		EXPECT_EQ(key % 2, 1);
+		sum += value;
+	}
+	EXPECT_EQ(sum, 2 * 5'000ull * 5'000ull);
+
+	// Erasing while iterating
+	for (auto iter = map.begin(); iter != map.end();)
+	{
+		iter = iter->first % 4 == 1 ? map.erase(iter) : std::next(iter);
+	}
+	EXPECT_EQ(map.size(), 2'500);
+	EXPECT_FALSE(map.contains(1));
+	EXPECT_TRUE(map.contains(3));
+
+	HashMap<u32, u32> copy = map;
+	EXPECT_EQ(copy.size(), map.size());
+	EXPECT_EQ(copy.at(3), 6);
+	HashMap<u32, u32> moved = std::move(copy);
+	EXPECT_TRUE(copy.empty());
+	EXPECT_EQ(copy.find(3), copy.end());
+	EXPECT_EQ(moved.at(3), 6);
+	moved.clear();
+	EXPECT_TRUE(moved.empty());
+	EXPECT_EQ(moved.begin(), moved.end());
+
+	// Empty tables don't allocate, also when they're copied
+	const HashMap<u32, u32> empty;
+	const HashMap<u32, u32> empty_copy = empty;
+	EXPECT_EQ(empty_copy.capacity(), 0);
+	EXPECT_EQ((HashMap<u32, u32>(0).capacity()), 0);
+
+	// A copy that throws half-way frees what it built, ASan reports a leak otherwise
+	HashMap<u32, ThrowingCopy> throwing;
+	for (u32 index = 0; index < 100; ++index)
+	{
+		throwing.try_emplace(index);
+	}
+	ThrowingCopy::s_CopiesLeft = 50;
+	EXPECT_THROW((HashMap<u32, ThrowingCopy>(throwing)), std::runtime_error);
+	ThrowingCopy::s_CopiesLeft = std::numeric_limits<u32>::max();
+
+	// Strings are searched by views without building a std::string
+	StringMap<std::string> strings;
+	strings["textures://"] = "assets/textures";
+	EXPECT_TRUE(strings.try_emplace(std::string_view("shaders://"), "assets/shaders").second);
+	EXPECT_FALSE(strings.try_emplace(std::string_view("shaders://"), "other").second);
+	EXPECT_EQ(strings.at(std::string_view("shaders://")), "assets/shaders");
+	EXPECT_EQ(strings.find("textures://")->second, "assets/textures");
+	EXPECT_FALSE(strings.contains(std::string_view("sounds://")));
+	for (u32 index = 0; index < 1000; ++index)
+	{
+		strings.insert_or_assign(std::to_string(index), std::to_string(index * 2));
+	}
+	EXPECT_EQ(strings.at("999"), "1998");
+	EXPECT_EQ(strings.erase(std::string_view("textures://")), 1);
+	EXPECT_EQ(strings.size(), 1001);
+
+	HashSet<std::string> set{ "a", "b", "a" };
+	EXPECT_EQ(set.size(), 2);
+	EXPECT_TRUE(set.contains("b"));
+	EXPECT_FALSE(set.insert("b").second);
+}
@@ -17,7 +17,7 @@ TEST(CoreTests, TestMemAllocFree)
 	{
 		aw::core::free_memory(allocation);
 	};
-	EXPECT_EQ(aw::core::get_allocation_size(allocation), 100);
+	EXPECT_EQ(aw::core::get_allocation_size(allocation), aw::core::HEADERLESS_ALLOCATIONS ? 112 : 100);
 }
 
 TEST(CoreTests, TestDefaultAllocator)
@@ -28,7 +28,7 @@ TEST(CoreTests, TestDefaultAllocator)
 	{
 		alloc.deallocate(a, 10);
 	};
-	EXPECT_EQ(aw::core::get_allocation_size(a), 10 * sizeof(int));
+	EXPECT_EQ(aw::core::get_allocation_size(a), aw::core::HEADERLESS_ALLOCATIONS ? 48 : 10 * sizeof(int));
 }
 
 TEST(CoreTests, TestAWNewDelete)
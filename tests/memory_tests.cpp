@@ -0,0 +1,1001 @@
+#include <gtest/gtest.h>
+
+#include "aw/core/all.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <numeric>
+
+using namespace aw::core;
+
+TEST(PagedMemoryPoolTests, TestThreadCacheReusesBlocks)
+{
+	void* first = allocate_memory(48);
+	free_memory(first);
+
+	void* second = allocate_memory(40);
+	defer[second] { free_memory(second); };
+
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(get_allocation_size(second), HEADERLESS_ALLOCATIONS ? 48 : 40);
+}
+
+TEST(PagedMemoryPoolTests, TestThreadCacheDepth)
+{
+	const u32 old_depth = PagedMemoryPool::get_thread_cache_depth();
+	defer[old_depth] { PagedMemoryPool::set_thread_cache_depth(old_depth); };
+
+	PagedMemoryPool::set_thread_cache_depth(ThreadCache::MAX_DEPTH * 2);
+	EXPECT_EQ(PagedMemoryPool::get_thread_cache_depth(), ThreadCache::MAX_DEPTH);
+
+	PagedMemoryPool::set_thread_cache_depth(0);
+	EXPECT_EQ(ThreadCache::get(), nullptr);
+
+	void* allocation = allocate_memory(100);
+	EXPECT_EQ(get_allocation_size(allocation), HEADERLESS_ALLOCATIONS ? 112 : 100);
+	free_memory(allocation);
+}
+
+TEST(PagedMemoryPoolTests, TestAllocationsSpanMultiplePages)
+{
+	// More blocks than fit into a single page
+	constexpr usize num_allocations = DEFAULT_PAGE_SIZE / SizeClasses::get_block_size(PagedMemoryPool::get_size_class_index(48)) + 1000;
+
+	Vector<void*> allocations;
+	allocations.reserve(num_allocations);
+	for (usize index = 0; index < num_allocations; ++index)
+	{
+		allocations.push_back(allocate_memory(48));
+	}
+
+	for (void* allocation : allocations)
+	{
+		ASSERT_NE(allocation, nullptr);
+		free_memory(allocation);
+	}
+
+	PagedMemoryPool::flush_thread_cache();
+}
+
+TEST(PagedMemoryPoolTests, TestThreadCacheConcurrentChurn)
+{
+	ThreadPool pool{ 4 };
+
+	for (i32 task_index = 0; task_index < 16; ++task_index)
+	{
+		pool.submit_task([task_index] {
+			Vector<u8*> allocations;
+			for (i32 iteration = 0; iteration < 2000; ++iteration)
+			{
+				const usize size = 16 + (iteration % 7) * 24;
+				const auto allocation = static_cast<u8*>(allocate_memory(size));
+				std::memset(allocation, task_index, size);
+				allocations.push_back(allocation);
+
+				if (allocations.size() > 64)
+				{
+					for (u8* old : allocations)
+					{
+						EXPECT_EQ(old[0], static_cast<u8>(task_index));
+						free_memory(old);
+					}
+					allocations.clear();
+				}
+			}
+
+			for (u8* old : allocations)
+			{
+				free_memory(old);
+			}
+			PagedMemoryPool::flush_thread_cache();
+		});
+	}
+
+	pool.wait_all();
+}
+
+TEST(PagedMemoryPoolTests, TestRemoteFreesAreReclaimed)
+{
+	constexpr usize	 size = 2500;
+	const u64		 size_class_index = PagedMemoryPool::get_size_class_index(size);
+	PagedMemoryPool& pool = PagedMemoryPool::get();
+
+	PagedMemoryPool::flush_thread_cache();
+
+	// The magazine refills from the tree and owns the page of the last refill
+	Vector<void*> allocations;
+	for (u32 index = 0; index < PagedMemoryPool::get_thread_cache_depth(); ++index)
+	{
+		allocations.push_back(allocate_memory(size));
+	}
+
+	// The cache of the other thread is flushed to the pages when it exits
+	std::thread([&allocations] {
+		for (void* allocation : allocations)
+		{
+			free_memory(allocation);
+		}
+	}).join();
+	const u64 reclaimed_before = pool.stats().size_classes[size_class_index].reclaimed_blocks;
+
+	// Once the magazine runs dry, the refills take the blocks freed to the owned page back.
+	// Blocks left over from an earlier reclaim come first, but those are at most a page.
+	const u64	  blocks_per_page = pool.get_page_tree(size_class_index)->get_blocks_per_page();
+	Vector<void*> reused;
+	while (reused.size() < blocks_per_page && (reused.empty() || std::ranges::find(allocations, reused.back()) == allocations.end()))
+	{
+		reused.push_back(allocate_memory(size));
+	}
+
+	EXPECT_NE(std::ranges::find(allocations, reused.back()), allocations.end());
+	EXPECT_GT(pool.stats().size_classes[size_class_index].reclaimed_blocks, reclaimed_before);
+
+	for (void* allocation : reused)
+	{
+		free_memory(allocation);
+	}
+	PagedMemoryPool::flush_thread_cache();
+}
+
+TEST(PagedMemoryPoolTests, TestPageFreeListABAStress)
+{
+	constexpr u32 num_blocks = 256;
+	constexpr u64 block_stride = 16;
+
+	alignas(16) static std::array<u8, num_blocks * block_stride> blocks{};
+	PageFreeList free_list(blocks.data(), block_stride);
+	for (u32 index = 0; index < num_blocks; ++index)
+	{
+		free_list.push(index);
+	}
+
+	// Every thread keeps popping a few blocks and pushing them back in a different order, so the same indices keep coming back to the head.
+	Vector<std::thread> threads;
+	for (u32 thread_index = 0; thread_index < 8; ++thread_index)
+	{
+		threads.emplace_back([&free_list] {
+			std::array<u32, 4> popped{};
+			for (u32 iteration = 0; iteration < 50000; ++iteration)
+			{
+				u32 num_popped = 0;
+				for (u32& index : popped)
+				{
+					index = free_list.pop();
+					if (index == PageFreeList::INVALID_INDEX)
+						break;
+					++num_popped;
+				}
+
+				for (u32 index = 0; index < num_popped; ++index)
+				{
+					free_list.push(popped[(index + iteration) % num_popped]);
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::array<bool, num_blocks> seen{};
+	u32 num_seen = 0;
+	for (u32 index = free_list.pop(); index != PageFreeList::INVALID_INDEX; index = free_list.pop())
+	{
+		ASSERT_LT(index, num_blocks);
+		EXPECT_FALSE(seen[index]);
+		seen[index] = true;
+		++num_seen;
+	}
+	EXPECT_EQ(num_seen, num_blocks);
+}
+
+TEST(PagedMemoryPoolTests, TestFullPagesBecomeAvailable)
+{
+	const u32 old_depth = PagedMemoryPool::get_thread_cache_depth();
+	PagedMemoryPool::set_thread_cache_depth(0);
+	defer[old_depth] { PagedMemoryPool::set_thread_cache_depth(old_depth); };
+
+	constexpr usize allocation_size = 2000;
+	PageTree*		tree = PagedMemoryPool::get().get_page_tree(PagedMemoryPool::get_size_class_index(allocation_size));
+	const usize		blocks_per_page = tree->get_blocks_per_page();
+
+	Vector<void*> allocations;
+	allocations.reserve(blocks_per_page * 2);
+	for (usize index = 0; index < blocks_per_page * 2; ++index)
+	{
+		allocations.push_back(allocate_memory(allocation_size));
+	}
+	EXPECT_GE(tree->get_num_pages(), 2);
+
+	// Freeing a block of a full page puts the page back in front of the available pages
+	void* freed = allocations.front();
+	free_memory(freed);
+	allocations.front() = allocate_memory(allocation_size);
+	EXPECT_EQ(allocations.front(), freed);
+
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation);
+	}
+
+	// Only the retained empty pages are left
+	if constexpr (CLEAR_EMPTY_PAGES)
+	{
+		EXPECT_EQ(tree->get_num_pages(), tree->get_num_empty_pages());
+		EXPECT_LE(tree->get_num_pages(), PagedMemoryPool::get_max_empty_pages_per_class());
+	}
+}
+
+TEST(PagedMemoryPoolTests, TestSizeClasses)
+{
+	EXPECT_EQ(SizeClasses::get_block_size(SizeClasses::get_index(1)), 16);
+	EXPECT_EQ(SizeClasses::get_block_size(SizeClasses::get_index(16)), 16);
+	EXPECT_EQ(SizeClasses::get_block_size(SizeClasses::get_index(17)), 32);
+	EXPECT_EQ(SizeClasses::get_block_size(SizeClasses::get_index(128)), 128);
+	EXPECT_EQ(SizeClasses::get_block_size(SizeClasses::get_index(129)), 160);
+	EXPECT_EQ(SizeClasses::get_block_size(SizeClasses::get_index(257)), 320);
+
+	// A 72-byte request used to take a 128-byte block
+	EXPECT_EQ(SizeClasses::get_block_size(PagedMemoryPool::get_size_class_index(72)), HEADERLESS_ALLOCATIONS ? 80 : 96);
+
+	for (u64 index = 1; index < SizeClasses::NUM_CLASSES; ++index)
+	{
+		const u64 block_size = SizeClasses::get_block_size(index);
+		const u64 prev_block_size = SizeClasses::get_block_size(index - 1);
+		ASSERT_GT(block_size, prev_block_size);
+
+		EXPECT_EQ(SizeClasses::get_index(block_size), index);
+		EXPECT_EQ(SizeClasses::get_index(prev_block_size + 1), index);
+
+		// Internal fragmentation is bounded by 20% above the small classes
+		if (prev_block_size >= SizeClasses::SMALL_LIMIT)
+		{
+			EXPECT_LE(block_size - (prev_block_size + 1), block_size / 5);
+		}
+	}
+}
+
+TEST(PagedMemoryPoolTests, TestPageLookupByAddress)
+{
+	// Without headers, 16-byte allocations take 16 bytes
+	constexpr u64 block_size = SizeClasses::get_block_size(PagedMemoryPool::get_size_class_index(16));
+	static_assert(block_size == (HEADERLESS_ALLOCATIONS ? 16 : 32));
+
+	auto* small = static_cast<u8*>(allocate_memory(16));
+	defer[small] { free_memory(small); };
+
+	const MemoryPage* page = MemoryPage::from_allocation(small);
+	const auto		  page_address = reinterpret_cast<std::uintptr_t>(page);
+	EXPECT_EQ(page_address % DEFAULT_PAGE_SIZE, 0);
+	EXPECT_EQ(page->get_block_size(), block_size);
+	EXPECT_FALSE(page->is_large_allocation());
+	EXPECT_EQ((reinterpret_cast<std::uintptr_t>(small) - ALLOCATION_HEADER_SIZE - page_address - MemoryPage::get_blocks_offset()) % block_size, 0);
+
+	// Allocations bigger than a page get a chunk of their own and keep their exact size
+	constexpr usize large_size = DEFAULT_PAGE_SIZE + 100;
+	auto*			large = static_cast<u8*>(allocate_memory(large_size));
+	defer[large] { free_memory(large); };
+
+	EXPECT_TRUE(MemoryPage::from_allocation(large)->is_large_allocation());
+	EXPECT_EQ(get_allocation_size(large), large_size);
+	large[0] = 1;
+	large[large_size - 1] = 1;
+}
+
+TEST(PagedMemoryPoolTests, TestPagesCommitLazily)
+{
+	const u32 old_depth = PagedMemoryPool::get_thread_cache_depth();
+	PagedMemoryPool::set_thread_cache_depth(0);
+	defer[old_depth] { PagedMemoryPool::set_thread_cache_depth(old_depth); };
+
+	// Nothing else allocates blocks of this class, so the page is fresh
+	constexpr usize allocation_size = 150000;
+	void*			first = allocate_memory(allocation_size);
+	const MemoryPage* page = MemoryPage::from_allocation(first);
+	const u64		  block_size = page->get_block_size();
+	EXPECT_GE(page->get_committed_size(), MemoryPage::get_blocks_offset() + block_size);
+	EXPECT_LT(page->get_committed_size(), DEFAULT_PAGE_SIZE);
+
+	Vector<void*> allocations{ first };
+	while (MemoryPage::from_allocation(allocations.back()) == page && allocations.size() < page->get_max_allocations())
+	{
+		allocations.push_back(allocate_memory(allocation_size));
+		std::memset(allocations.back(), 0xAB, allocation_size);
+	}
+	EXPECT_GE(page->get_committed_size(), MemoryPage::get_blocks_offset() + page->get_max_allocations() * block_size);
+
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation);
+	}
+
+	// With huge pages, pages are committed in steps of a huge page
+	PagedMemoryPool::set_huge_pages_enabled(true);
+	defer[] { PagedMemoryPool::set_huge_pages_enabled(false); };
+
+	void* huge_page_allocation = allocate_memory(allocation_size * 2);
+	EXPECT_GE(MemoryPage::from_allocation(huge_page_allocation)->get_committed_size(), MemoryPage::HUGE_PAGE_COMMIT_STEP);
+	free_memory(huge_page_allocation);
+}
+
+TEST(PagedMemoryPoolTests, TestVirtualMemory)
+{
+	constexpr Bytes size = Megabytes(1);
+	auto*			memory = static_cast<u8*>(VirtualMemory::reserve(size, size));
+	ASSERT_NE(memory, nullptr);
+	defer[memory, size] { VirtualMemory::release(memory, size); };
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(memory) % size, 0);
+
+	const u64 page_size = VirtualMemory::get_page_size();
+	ASSERT_TRUE(VirtualMemory::commit(memory, page_size));
+	memory[0] = 42;
+	memory[page_size - 1] = 42;
+
+	// Decommitted memory comes back zeroed
+	VirtualMemory::decommit(memory, page_size);
+	ASSERT_TRUE(VirtualMemory::commit(memory, page_size));
+	EXPECT_EQ(memory[0], 0);
+}
+
+TEST(PagedMemoryPoolTests, TestNumaPageTrees)
+{
+	const u32 num_nodes = Numa::get_num_nodes();
+	ASSERT_GE(num_nodes, 1);
+	ASSERT_LE(num_nodes, Numa::MAX_NODES);
+	EXPECT_LT(Numa::get_current_node(), num_nodes);
+
+	// Every node has trees of its own, even ones the machine doesn't have
+	PagedMemoryPool heap;
+	const u64		size_class_index = PagedMemoryPool::get_size_class_index(100);
+	PageTree*		first_tree = heap.get_page_tree(size_class_index, 0);
+	PageTree*		second_tree = heap.get_page_tree(size_class_index, 1);
+	EXPECT_NE(first_tree, second_tree);
+	EXPECT_EQ(second_tree->get_node(), 1);
+
+	void* block = second_tree->allocate_block(100);
+	ASSERT_NE(block, nullptr);
+	EXPECT_EQ(MemoryPage::from_allocation(block)->get_tree(), second_tree);
+	free_memory(block);
+	EXPECT_EQ(heap.stats().size_classes[size_class_index].total_allocations, 1);
+
+	EXPECT_EQ(heap.get_page_tree(size_class_index)->get_node(), Numa::get_current_node());
+
+	PagedMemoryPool::set_numa_aware(false);
+	defer[] { PagedMemoryPool::set_numa_aware(true); };
+	EXPECT_EQ(heap.get_page_tree(size_class_index), first_tree);
+}
+
+TEST(PagedMemoryPoolTests, TestEmptyPagesAreRetained)
+{
+	if constexpr (!CLEAR_EMPTY_PAGES)
+	{
+		GTEST_SKIP() << "Empty pages are never released";
+	}
+
+	const u32	old_depth = PagedMemoryPool::get_thread_cache_depth();
+	const u32	old_max_empty_pages = PagedMemoryPool::get_max_empty_pages_per_class();
+	const Bytes old_max_retained_bytes = PagedMemoryPool::get_max_retained_bytes();
+	PagedMemoryPool::set_thread_cache_depth(0);
+	PagedMemoryPool::set_max_empty_pages_per_class(1);
+	PagedMemoryPool::set_max_retained_bytes(Megabytes(1024));
+	defer[=]
+	{
+		PagedMemoryPool::set_thread_cache_depth(old_depth);
+		PagedMemoryPool::set_max_empty_pages_per_class(old_max_empty_pages);
+		PagedMemoryPool::set_max_retained_bytes(old_max_retained_bytes);
+	};
+
+	constexpr usize allocation_size = 5000;
+	PageTree*		tree = PagedMemoryPool::get().get_page_tree(PagedMemoryPool::get_size_class_index(allocation_size));
+
+	// Fill the first page and put a single block on the second one
+	Vector<void*> allocations;
+	for (usize index = 0; index < tree->get_blocks_per_page() + 1; ++index)
+	{
+		allocations.push_back(allocate_memory(allocation_size));
+	}
+	ASSERT_EQ(tree->get_num_pages(), 2);
+
+	// Crossing the page boundary back and forth keeps reusing the same page
+	void* boundary_block = allocations.back();
+	for (u32 cycle = 0; cycle < 3; ++cycle)
+	{
+		free_memory(allocations.back());
+		EXPECT_EQ(tree->get_num_pages(), 2);
+		EXPECT_EQ(tree->get_num_empty_pages(), 1);
+
+		allocations.back() = allocate_memory(allocation_size);
+		EXPECT_EQ(allocations.back(), boundary_block);
+		EXPECT_EQ(tree->get_num_empty_pages(), 0);
+	}
+
+	// Trimming gives the memory of the empty page back, but the page can still be reused
+	free_memory(allocations.back());
+	EXPECT_GT(PagedMemoryPool::get_retained_bytes(), 0);
+	EXPECT_GT(PagedMemoryPool::get().trim(), 0);
+	EXPECT_LT(MemoryPage::from_allocation(boundary_block)->get_committed_size(), MemoryPage::COMMIT_STEP);
+
+	allocations.back() = allocate_memory(allocation_size);
+	EXPECT_EQ(allocations.back(), boundary_block);
+	std::memset(allocations.back(), 0xAB, allocation_size);
+
+	// Without retention, the page is released right away
+	PagedMemoryPool::set_max_empty_pages_per_class(0);
+	free_memory(allocations.back());
+	allocations.pop_back();
+	EXPECT_EQ(tree->get_num_pages(), 1);
+
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation);
+	}
+	EXPECT_EQ(tree->get_num_pages(), 0);
+}
+
+TEST(PagedMemoryPoolTests, TestAlignedAllocations)
+{
+	for (const u64 alignment : { 8ull, 16ull, 32ull, 64ull, 256ull, 4096ull, 65536ull, 1ull << 20 })
+	{
+		for (const usize size : { 1ull, 24ull, 100ull, 5000ull, 3'000'000ull, 5'000'000ull })
+		{
+			auto* memory = static_cast<u8*>(allocate_memory_aligned(size, alignment));
+			ASSERT_NE(memory, nullptr);
+			EXPECT_EQ(reinterpret_cast<std::uintptr_t>(memory) % alignment, 0) << size << " bytes aligned to " << alignment;
+			EXPECT_GE(get_allocation_size(memory), size);
+
+			std::memset(memory, 0xAB, size);
+			free_memory(memory);
+		}
+	}
+
+	// Alignments up to 4 KB are served from pages
+	void* page_aligned = allocate_memory_aligned(100, 4096);
+	EXPECT_FALSE(MemoryPage::from_allocation(page_aligned)->is_large_allocation());
+	free_memory(page_aligned);
+}
+
+TEST(PagedMemoryPoolTests, TestAlignedBlocksAreReusedAsRegularBlocks)
+{
+	// An aligned allocation points into its block. Once freed to the thread cache, the whole block must be handed out again.
+	constexpr usize size = 200;
+	const usize		padded_size = size + 256 - PagedMemoryPool::MIN_ALIGNMENT;
+	for (u32 iteration = 0; iteration < 64; ++iteration)
+	{
+		void* aligned = allocate_memory_aligned(size, 256);
+		free_memory(aligned);
+
+		auto* regular = static_cast<u8*>(allocate_memory(padded_size));
+		EXPECT_EQ(get_allocation_size(regular), HEADERLESS_ALLOCATIONS ? SizeClasses::get_block_size(PagedMemoryPool::get_size_class_index(padded_size)) : padded_size);
+		std::memset(regular, 0xCD, padded_size);
+		free_memory(regular);
+	}
+}
+
+TEST(PagedMemoryPoolTests, TestAlignedAllocator)
+{
+	struct alignas(64) PaddedCounter
+	{
+		std::atomic<u64> value{};
+	};
+
+	Vector<f32, AlignedAllocator<f32, 32>> floats(37, 1.0f);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(floats.data()) % 32, 0);
+
+	Vector<PaddedCounter> counters(8);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(counters.data()) % 64, 0);
+
+	HashMap<i32, i32, std::hash<i32>, std::equal_to<i32>, AlignedAllocator<std::pair<const i32, i32>, 64>> map;
+	for (i32 index = 0; index < 100; ++index)
+	{
+		map.emplace(index, index * 2);
+	}
+	EXPECT_EQ(map.at(42), 84);
+
+	PaddedCounter* counter = aw_new PaddedCounter;
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(counter) % 64, 0);
+	aw_delete(counter);
+}
+
+TEST(PagedMemoryPoolTests, TestSeparateHeaps)
+{
+	constexpr usize size = 48;
+	const u64		size_class_index = PagedMemoryPool::get_size_class_index(size);
+	const u64		live_large_allocations = PagedMemoryPool::get().stats().live_large_allocations;
+	{
+		PagedMemoryPool heap;
+		void*			block = allocate_memory(heap, size);
+		ASSERT_NE(block, nullptr);
+		EXPECT_EQ(MemoryPage::from_allocation(block)->get_tree(), heap.get_page_tree(size_class_index));
+		EXPECT_EQ(MemoryPage::from_allocation(block)->get_heap(), &heap);
+		EXPECT_EQ(heap.stats().size_classes[size_class_index].live_blocks, 1);
+
+		// The block goes back to its own heap, not into the thread cache of the default heap
+		free_memory(block);
+		void* default_block = allocate_memory(size);
+		EXPECT_NE(default_block, block);
+		EXPECT_EQ(MemoryPage::from_allocation(default_block)->get_heap(), &PagedMemoryPool::get());
+		free_memory(default_block);
+		EXPECT_EQ(heap.stats().size_classes[size_class_index].live_blocks, 0);
+
+		// Moved memory stays in the heap, even when reallocated through the default heap
+		auto* numbers = static_cast<u32*>(allocate_memory(heap, 16 * sizeof(u32)));
+		std::iota(numbers, numbers + 16, 0u);
+		numbers = static_cast<u32*>(reallocate_memory(numbers, 1024 * sizeof(u32)));
+		EXPECT_EQ(MemoryPage::from_allocation(numbers)->get_heap(), &heap);
+		EXPECT_EQ(numbers[15], 15);
+		free_memory(numbers);
+
+		// Neither the blocks nor the large allocations have to be freed, the heap releases them with its pages
+		for (u32 index = 0; index < 100; ++index)
+		{
+			EXPECT_NE(allocate_memory(heap, size), nullptr);
+		}
+
+		void* large = allocate_memory(heap, 8 * 1024 * 1024);
+		ASSERT_NE(large, nullptr);
+		EXPECT_EQ(MemoryPage::from_allocation(large)->get_heap(), &heap);
+
+		void* remapped = allocate_memory(heap, 100 * 1024 * 1024);
+		ASSERT_NE(remapped, nullptr);
+		remapped = reallocate_memory(remapped, 200 * 1024 * 1024);
+		ASSERT_NE(remapped, nullptr);
+		EXPECT_EQ(PagedMemoryPool::get().stats().live_large_allocations, live_large_allocations + 2);
+	}
+
+	EXPECT_EQ(PagedMemoryPool::get().stats().live_large_allocations, live_large_allocations);
+}
+
+TEST(PagedMemoryPoolTests, TestHeapAllocator)
+{
+	PagedMemoryPool heap;
+	{
+		Vector<u64, HeapAllocator<u64>> numbers{ HeapAllocator<u64>(heap) };
+		for (u64 index = 0; index < 1000; ++index)
+		{
+			numbers.push_back(index);
+		}
+		EXPECT_EQ(MemoryPage::from_allocation(numbers.data())->get_heap(), &heap);
+
+		HashMap<i32, i32, std::hash<i32>, std::equal_to<i32>, HeapAllocator<std::pair<const i32, i32>>> map{ HeapAllocator<std::pair<const i32, i32>>(heap) };
+		map.emplace(1, 2);
+		EXPECT_EQ(&map.get_allocator().get_heap(), &heap);
+
+		// Containers on different heaps swap their allocators along with the memory
+		Vector<u64, HeapAllocator<u64>> other{ 5, 7 };
+		EXPECT_NE(numbers.get_allocator(), other.get_allocator());
+		numbers.swap(other);
+		EXPECT_EQ(&other.get_allocator().get_heap(), &heap);
+		EXPECT_EQ(&numbers.get_allocator().get_heap(), &PagedMemoryPool::get());
+	}
+
+	const PoolStats stats = heap.stats();
+	EXPECT_EQ(std::accumulate(stats.size_classes.begin(), stats.size_classes.end(), u64{ 0 }, [](const u64 sum, const SizeClassStats& size_class) { return sum + size_class.live_blocks; }), 0);
+}
+
+namespace
+{
+	std::atomic<u32> g_NewPages{};
+	std::atomic<u32> g_NewChunks{};
+} // namespace
+
+TEST(PagedMemoryPoolTests, TestReserve)
+{
+	PagedMemoryPool::set_numa_aware(false);
+	defer[] { PagedMemoryPool::set_numa_aware(true); };
+
+	PagedMemoryPool::set_growth_hook([](const PoolGrowthEvent& event) {
+		(event.kind == PoolGrowthEvent::Kind::Page ? g_NewPages : g_NewChunks).fetch_add(1, std::memory_order::relaxed);
+	});
+	defer[] { PagedMemoryPool::set_growth_hook(nullptr); };
+
+	constexpr usize size = 1000;
+	const u64		size_class_index = PagedMemoryPool::get_size_class_index(size);
+	PagedMemoryPool heap;
+	PageTree*		tree = heap.get_page_tree(size_class_index);
+	const u64		num_blocks = tree->get_blocks_per_page() * 2 + 1;
+
+	g_NewPages = 0;
+	EXPECT_EQ(heap.reserve(size_class_index, num_blocks), 3);
+	EXPECT_EQ(g_NewPages.load(), 3);
+	EXPECT_EQ(tree->get_num_pages(), 3);
+	EXPECT_GE(tree->get_committed_bytes(), num_blocks * tree->get_block_size());
+
+	// The reserved blocks are there already, so neither reserving again nor allocating them grows the heap
+	EXPECT_EQ(heap.reserve(size_class_index, num_blocks), 0);
+	std::vector<void*> blocks;
+	for (u64 index = 0; index < num_blocks; ++index)
+	{
+		blocks.push_back(allocate_memory(heap, size));
+		ASSERT_NE(blocks.back(), nullptr);
+	}
+	EXPECT_EQ(g_NewPages.load(), 3);
+	EXPECT_EQ(tree->get_num_pages(), 3);
+
+	for (void* block : blocks)
+	{
+		free_memory(block);
+	}
+
+	// Every size class that is served from pages gets a page
+	PagedMemoryPool other_heap;
+	g_NewPages = 0;
+	EXPECT_EQ(other_heap.reserve(Kilobytes(64)), PagedMemoryPool::MAX_PAGED_SIZE_CLASS_INDEX + 1);
+	EXPECT_EQ(g_NewPages.load(), PagedMemoryPool::MAX_PAGED_SIZE_CLASS_INDEX + 1);
+
+	// Chunks of the BuddyAllocator come from its arenas, only bigger ones are reported
+	g_NewChunks = 0;
+	void* buddy_block = allocate_memory(heap, 8 * 1024 * 1024);
+	void* chunk = allocate_memory(heap, 100 * 1024 * 1024);
+	EXPECT_EQ(g_NewChunks.load(), 1);
+	free_memory(chunk);
+	free_memory(buddy_block);
+}
+
+namespace
+{
+	struct TestMemoryTag
+	{
+		static constexpr std::string_view name = "test";
+	};
+
+	std::atomic<u32> g_BudgetHookCalls{};
+} // namespace
+
+TEST(PagedMemoryPoolTests, TestMemoryTags)
+{
+	PagedMemoryPool& heap = MemoryTags::get_heap<TestMemoryTag>();
+	EXPECT_NE(&heap, &PagedMemoryPool::get());
+	EXPECT_EQ(&heap, &MemoryTags::get_heap<TestMemoryTag>());
+	ASSERT_EQ(heap.get_live_bytes(), 0);
+	{
+		TaggedVector<u64, TestMemoryTag> numbers(1000);
+		EXPECT_EQ(MemoryPage::from_allocation(numbers.data())->get_heap(), &heap);
+		EXPECT_GE(heap.get_live_bytes(), 1000 * sizeof(u64));
+
+		TaggedHashMap<u32, u32, TestMemoryTag> map;
+		map[1] = 2;
+
+		auto* number = aw_new_tagged(TestMemoryTag) u64(42);
+		EXPECT_EQ(MemoryPage::from_allocation(number)->get_heap(), &heap);
+		aw_delete(number);
+
+		// Large allocations count with their chunk, also when they grow in place or move
+		const u64 live_bytes = heap.get_live_bytes();
+		void*	  large = allocate_memory(heap, 8 * 1024 * 1024);
+		EXPECT_GE(heap.get_live_bytes(), live_bytes + 8 * 1024 * 1024);
+		large = reallocate_memory(large, 100 * 1024 * 1024);
+		ASSERT_NE(large, nullptr);
+		EXPECT_GE(heap.get_live_bytes(), live_bytes + 100 * 1024 * 1024);
+		free_memory(large);
+		EXPECT_EQ(heap.get_live_bytes(), live_bytes);
+
+		const std::vector<MemoryTagStats> stats = MemoryTags::stats();
+		EXPECT_TRUE(std::ranges::any_of(stats, [&heap](const MemoryTagStats& tag) { return tag.name == "test" && tag.live_bytes == heap.get_live_bytes(); }));
+		EXPECT_NE(MemoryTags::to_string().find("test"), std::string::npos);
+	}
+	EXPECT_EQ(heap.get_live_bytes(), 0);
+	EXPECT_GT(heap.get_peak_live_bytes(), 100 * 1024 * 1024);
+
+	// Over the budget, allocations fail unless the hook lets them through
+	heap.set_budget(Kilobytes(4));
+	defer[&heap] { heap.set_budget(std::numeric_limits<u64>::max()); };
+	void* block = allocate_memory(heap, 1000);
+	ASSERT_NE(block, nullptr);
+	EXPECT_EQ(allocate_memory(heap, 4000), nullptr);
+	EXPECT_THROW((TaggedVector<u8, TestMemoryTag>(8000)), std::bad_alloc);
+	EXPECT_EQ(heap.get_num_budget_failures(), 2);
+
+	heap.set_budget(Kilobytes(4), [](PagedMemoryPool&, const u64 requested_bytes) {
+		g_BudgetHookCalls.fetch_add(1, std::memory_order::relaxed);
+		return requested_bytes < 8192;
+	});
+	void* allowed = allocate_memory(heap, 4000);
+	EXPECT_NE(allowed, nullptr);
+	EXPECT_EQ(allocate_memory(heap, 10000), nullptr);
+	EXPECT_EQ(g_BudgetHookCalls.load(), 2);
+	free_memory(allowed);
+	free_memory(block);
+	EXPECT_EQ(heap.get_live_bytes(), 0);
+}
+
+TEST(PagedMemoryPoolTests, TestPoolStats)
+{
+	constexpr usize allocation_size = 1500;
+	constexpr usize num_allocations = 100;
+	constexpr usize large_allocation_size = 8 * 1024 * 1024;
+	const u64		size_class_index = PagedMemoryPool::get_size_class_index(allocation_size);
+	PagedMemoryPool& pool = PagedMemoryPool::get();
+
+	// Otherwise the large allocation may get a block that is still committed from an earlier test
+	pool.trim();
+	const PoolStats before = pool.stats();
+
+	// Allocations of another thread are counted after it exited
+	std::thread thread([] {
+		for (usize index = 0; index < num_allocations; ++index)
+		{
+			free_memory(allocate_memory(allocation_size));
+		}
+	});
+	thread.join();
+
+	Vector<void*> allocations;
+	for (usize index = 0; index < num_allocations; ++index)
+	{
+		allocations.push_back(allocate_memory(allocation_size));
+	}
+	void* large_allocation = allocate_memory(large_allocation_size);
+
+	const PoolStats			during = pool.stats();
+	const SizeClassStats& size_class = during.size_classes[size_class_index];
+	EXPECT_EQ(size_class.block_size, SizeClasses::get_block_size(size_class_index));
+	EXPECT_EQ(size_class.live_blocks - before.size_classes[size_class_index].live_blocks, num_allocations);
+	EXPECT_EQ(size_class.total_allocations - before.size_classes[size_class_index].total_allocations, 2 * num_allocations);
+	EXPECT_GE(size_class.num_pages, 1);
+	EXPECT_GE(size_class.committed_bytes, size_class.used_bytes);
+	EXPECT_EQ(during.live_large_allocations - before.live_large_allocations, 1);
+	EXPECT_GE(during.large_allocation_bytes - before.large_allocation_bytes, large_allocation_size);
+	EXPECT_GE(during.peak_large_allocation_bytes, during.large_allocation_bytes);
+	EXPECT_GE(during.committed_bytes, before.committed_bytes + large_allocation_size);
+	EXPECT_GE(during.peak_committed_bytes, during.committed_bytes);
+
+	const nlohmann::json document = nlohmann::json::parse(during.to_json());
+	EXPECT_EQ(document["large_allocations"]["live"], during.live_large_allocations);
+	EXPECT_FALSE(document["size_classes"].empty());
+	EXPECT_NE(during.to_string().find(std::to_string(size_class.block_size)), std::string::npos);
+
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation);
+	}
+	free_memory(large_allocation);
+
+	const PoolStats after = pool.stats();
+	EXPECT_EQ(after.size_classes[size_class_index].live_blocks, before.size_classes[size_class_index].live_blocks);
+	EXPECT_EQ(after.live_large_allocations, before.live_large_allocations);
+	EXPECT_EQ(after.large_allocation_bytes, before.large_allocation_bytes);
+}
+
+TEST(PagedMemoryPoolTests, TestBuddyAllocator)
+{
+	PagedMemoryPool& pool = PagedMemoryPool::get();
+	pool.trim();
+	const BuddyStats before = pool.stats().buddy;
+
+	// A chunk of a bit more than 4 MB takes an 8 MB block, and the rest of the arena is split into free blocks
+	constexpr usize size = 5 * 1024 * 1024;
+	auto*			first = static_cast<u8*>(allocate_memory(size));
+	ASSERT_NE(first, nullptr);
+	const MemoryPage* page = MemoryPage::from_allocation(first);
+	EXPECT_TRUE(page->is_large_allocation());
+	EXPECT_TRUE(page->is_buddy_block());
+	EXPECT_EQ(page->get_chunk_size(), 8 * 1024 * 1024);
+	EXPECT_EQ(get_allocation_size(first), size);
+	std::memset(first, 0xAB, size);
+
+	const BuddyStats during = pool.stats().buddy;
+	EXPECT_EQ(during.live_allocations, before.live_allocations + 1);
+	EXPECT_EQ(during.live_block_bytes, before.live_block_bytes + 8 * 1024 * 1024);
+	EXPECT_GE(during.committed_bytes, before.committed_bytes + size);
+
+	// The freed block keeps its memory and is handed out again, also to an allocation of another size
+	free_memory(first);
+	void* second = allocate_memory(size - 1024 * 1024);
+	EXPECT_EQ(MemoryPage::from_allocation(second), page);
+	EXPECT_EQ(pool.stats().buddy.recycled_allocations, during.recycled_allocations + 1);
+	free_memory(second);
+
+	// Allocations just under a page don't take a page of their own
+	void* almost_page = allocate_memory(DEFAULT_PAGE_SIZE - 1024);
+	EXPECT_TRUE(MemoryPage::from_allocation(almost_page)->is_buddy_block());
+	free_memory(almost_page);
+
+	// Blocks of all orders, with aligned ones in between
+	Vector<void*> allocations;
+	for (const usize block_size : { 4, 8, 16, 4, 32, 12, 3, 2 })
+	{
+		const usize allocation_size = block_size * 1024 * 1024 - 4096;
+		auto*		memory = static_cast<u8*>(block_size % 2 == 0 ? allocate_memory(allocation_size) : allocate_memory_aligned(allocation_size, 1 << 20));
+		ASSERT_NE(memory, nullptr);
+		EXPECT_TRUE(MemoryPage::from_allocation(memory)->is_buddy_block());
+		memory[0] = 1;
+		memory[allocation_size - 1] = 1;
+		allocations.push_back(memory);
+	}
+
+	const BuddyStats full = pool.stats().buddy;
+	EXPECT_EQ(full.live_allocations, before.live_allocations + allocations.size());
+	EXPECT_GE(full.num_arenas, 2);
+
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation);
+	}
+
+	// The blocks keep their memory until the pool is trimmed, which merges them back into whole arenas and releases them
+	const BuddyStats after = pool.stats().buddy;
+	EXPECT_EQ(after.live_allocations, before.live_allocations);
+	EXPECT_EQ(after.live_block_bytes, before.live_block_bytes);
+	EXPECT_GE(after.free_block_bytes, full.live_block_bytes - before.live_block_bytes);
+
+	pool.trim();
+	const BuddyStats trimmed = pool.stats().buddy;
+	EXPECT_EQ(trimmed.num_arenas, before.num_arenas);
+	EXPECT_EQ(trimmed.committed_bytes, before.committed_bytes);
+
+	// Chunks bigger than the biggest block come from the OS
+	void* huge = allocate_memory(BuddyAllocator::MAX_BLOCK_SIZE);
+	EXPECT_TRUE(MemoryPage::from_allocation(huge)->is_large_allocation());
+	EXPECT_FALSE(MemoryPage::from_allocation(huge)->is_buddy_block());
+	free_memory(huge);
+}
+
+TEST(PagedMemoryPoolTests, TestSizedFree)
+{
+	PagedMemoryPool& pool = PagedMemoryPool::get();
+	const u64		 size_class_index = PagedMemoryPool::get_size_class_index(700);
+	const PoolStats	 before = pool.stats();
+
+	Vector<void*> allocations;
+	for (u32 index = 0; index < 100; ++index)
+	{
+		allocations.push_back(allocate_memory(700));
+	}
+
+	void* large = allocate_memory(5 * 1024 * 1024);
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation, 700);
+	}
+	free_memory(large, 5 * 1024 * 1024);
+	free_memory(nullptr, 700);
+
+	const PoolStats after = pool.stats();
+	EXPECT_EQ(after.size_classes[size_class_index].live_blocks, before.size_classes[size_class_index].live_blocks);
+	EXPECT_EQ(after.live_large_allocations, before.live_large_allocations);
+
+	// The blocks went back to the same size class and are handed out again
+	void* reused = allocate_memory(700);
+	EXPECT_NE(std::ranges::find(allocations, reused), allocations.end());
+	free_memory(reused, 700);
+}
+
+TEST(PagedMemoryPoolTests, TestReallocate)
+{
+	// Stays in place within the size class
+	const u64 block_size = SizeClasses::get_block_size(PagedMemoryPool::get_size_class_index(1000));
+	auto*	  memory = static_cast<u8*>(reallocate_memory(nullptr, 1000));
+	ASSERT_NE(memory, nullptr);
+	std::memset(memory, 0x11, 1000);
+	EXPECT_EQ(reallocate_memory(memory, block_size - ALLOCATION_HEADER_SIZE), memory);
+	EXPECT_GE(get_allocation_size(memory), HEADERLESS_ALLOCATIONS ? block_size : block_size - ALLOCATION_HEADER_SIZE);
+	EXPECT_EQ(get_usable_allocation_size(memory), block_size - ALLOCATION_HEADER_SIZE);
+
+	// Moves to a bigger class and keeps everything that was written to the block
+	std::memset(memory, 0x22, get_usable_allocation_size(memory));
+	auto* moved = static_cast<u8*>(reallocate_memory(memory, 10000));
+	ASSERT_NE(moved, nullptr);
+	EXPECT_NE(moved, memory);
+	EXPECT_TRUE(std::all_of(moved, moved + block_size - ALLOCATION_HEADER_SIZE, [](const u8 value) { return value == 0x22; }));
+
+	// Grows into a large allocation, then within its buddy block
+	auto* large = static_cast<u8*>(reallocate_memory(moved, 5 * 1024 * 1024));
+	ASSERT_NE(large, nullptr);
+	EXPECT_EQ(large[0], 0x22);
+	EXPECT_TRUE(MemoryPage::from_allocation(large)->is_buddy_block());
+	large[5 * 1024 * 1024 - 1] = 0x33;
+	EXPECT_EQ(reallocate_memory(large, 7 * 1024 * 1024), large);
+	EXPECT_EQ(get_allocation_size(large), 7 * 1024 * 1024);
+	large[7 * 1024 * 1024 - 1] = 0x33;
+
+	// Chunks of their own move by remapping their pages, and keep their contents either way
+	auto* huge = static_cast<u8*>(reallocate_memory(large, 80 * 1024 * 1024));
+	ASSERT_NE(huge, nullptr);
+	EXPECT_FALSE(MemoryPage::from_allocation(huge)->is_buddy_block());
+	EXPECT_EQ(huge[0], 0x22);
+	EXPECT_EQ(huge[7 * 1024 * 1024 - 1], 0x33);
+	huge[80 * 1024 * 1024 - 1] = 0x44;
+
+	const PoolStats before_growth = PagedMemoryPool::get().stats();
+	huge = static_cast<u8*>(reallocate_memory(huge, 150 * 1024 * 1024));
+	ASSERT_NE(huge, nullptr);
+	EXPECT_EQ(huge[7 * 1024 * 1024 - 1], 0x33);
+	EXPECT_EQ(huge[80 * 1024 * 1024 - 1], 0x44);
+	huge[150 * 1024 * 1024 - 1] = 0x55;
+	EXPECT_EQ(PagedMemoryPool::get().stats().large_allocation_bytes - before_growth.large_allocation_bytes, 70 * 1024 * 1024);
+
+	huge = static_cast<u8*>(reallocate_memory(huge, 100 * 1024 * 1024));
+	ASSERT_NE(huge, nullptr);
+	EXPECT_EQ(huge[80 * 1024 * 1024 - 1], 0x44);
+	EXPECT_EQ(get_allocation_size(huge), 100 * 1024 * 1024);
+
+	// Shrinks back into the size classes
+	auto* small = static_cast<u8*>(reallocate_memory(huge, 100));
+	ASSERT_NE(small, nullptr);
+	EXPECT_FALSE(MemoryPage::from_allocation(small)->is_large_allocation());
+	EXPECT_EQ(small[99], 0x22);
+
+	EXPECT_EQ(reallocate_memory(small, 0), nullptr);
+}
+
+TEST(PagedMemoryPoolTests, TestHeapProfiler)
+{
+	constexpr usize num_allocations = 20;
+	const u64		live_samples_before = HeapProfiler::get_num_live_samples();
+
+	// Reserved up front, so the storage of the vector isn't sampled
+	Vector<void*> allocations;
+	allocations.reserve(num_allocations);
+
+	// With a mean of one byte between samples, every allocation is sampled
+	HeapProfiler::set_sample_interval(1);
+	defer[]
+	{
+		HeapProfiler::set_sample_interval(0);
+	};
+
+	for (usize index = 0; index < num_allocations; ++index)
+	{
+		allocations.push_back(allocate_memory(256));
+	}
+	void* aligned_allocation = allocate_memory_aligned(1000, 256);
+	void* large_allocation = allocate_memory(8 * 1024 * 1024);
+
+	EXPECT_GE(HeapProfiler::get_num_live_samples(), live_samples_before + num_allocations + 2);
+
+	// The allocations of the loop share their call stack. Scoped, as the vector is sampled too when operator new goes to the pool.
+	{
+		const std::vector<HeapProfiler::CallSite> sites = HeapProfiler::get_live_call_sites();
+		ASSERT_FALSE(sites.empty());
+		EXPECT_TRUE(std::ranges::any_of(sites, [](const HeapProfiler::CallSite& site) { return site.num_samples >= num_allocations && site.num_frames > 0; }));
+		EXPECT_GE(sites.front().estimated_bytes, sites.back().estimated_bytes);
+		EXPECT_NE(HeapProfiler::dump().find("heap profile"), std::string::npos);
+	}
+
+	HeapProfiler::set_sample_interval(0);
+	for (void* allocation : allocations)
+	{
+		free_memory(allocation);
+	}
+	free_memory(aligned_allocation);
+	free_memory(large_allocation);
+
+	// Frees of sampled allocations are tracked after the profiler is disabled
+	EXPECT_EQ(HeapProfiler::get_num_live_samples(), live_samples_before);
+}
+
+namespace
+{
+	std::atomic<u32> g_NewHandlerCalls{};
+} // namespace
+
+TEST(PagedMemoryPoolTests, TestOverAlignedNew)
+{
+	// Returns, as if it had freed a reserve, so a new that kept retrying would never end
+	const std::new_handler previous_handler = std::set_new_handler([] { ++g_NewHandlerCalls; });
+	defer[previous_handler] { std::set_new_handler(previous_handler); };
+
+	constexpr std::align_val_t alignment{ 2 * PagedMemoryPool::MAX_ALIGNMENT };
+	constexpr usize			   size = 2 * PagedMemoryPool::MAX_ALIGNMENT;
+#ifdef AW_REPLACE_NEW_DELETE
+	// The pool can't align to more than half a page
+	EXPECT_THROW(::operator delete(::operator new(size, alignment), alignment), std::bad_alloc);
+	EXPECT_EQ(::operator new(size, alignment, std::nothrow), nullptr);
+#else
+	void* memory = ::operator new(size, alignment);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(memory) % static_cast<usize>(alignment), 0);
+	::operator delete(memory, alignment);
+#endif
+	EXPECT_EQ(g_NewHandlerCalls, 0);
+
+	// Alignments up to the limit are served by the pool
+	void* aligned = ::operator new(1000, std::align_val_t{ PagedMemoryPool::MAX_ALIGNMENT });
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % PagedMemoryPool::MAX_ALIGNMENT, 0);
+	::operator delete(aligned, std::align_val_t{ PagedMemoryPool::MAX_ALIGNMENT });
+}